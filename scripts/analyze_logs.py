@@ -5,9 +5,18 @@ from collections import defaultdict
 # Usage: python analyze_logs.py <sim_log.txt>
 # Pass '-' to read from stdin
 
-send_pattern = re.compile(r"(?P<time>\d+) ns \[iRC(?P<tx>_tx)?\] sender_thread.*seq_num=(?P<seq>\d+)")
+# open-loop traffic (--traffic=...) adds the packet's arrival time, so latency
+# then includes the wait in iRC's source queue
+# SystemC prints each timestamp in the largest whole unit ("32 us", "5 ms")
+TIME = r"(?P<time>\d+(?:\.\d+)?) (?P<unit>[munp]?s)"
+UNIT_NS = {'s': 1e9, 'ms': 1e6, 'us': 1e3, 'ns': 1, 'ps': 1e-3}
+
+send_pattern = re.compile(TIME + r" \[iRC(?P<tx>_tx)?\] sender_thread.*seq_num=(?P<seq>\d+)"
+                          r"(?: thread_id=\d+)?(?: arrival_ns=(?P<arr>\d+))?")
 # pop pattern captures queue name so we can identify topology via prefix
-pop_pattern = re.compile(r"(?P<time>\d+) ns \[(?P<queue>[^\]]+)\] process_popped_data.*seq_num=(?P<seq>\d+)")
+pop_pattern = re.compile(TIME + r" \[(?P<queue>[^\]]+)\] process_popped_data.*seq_num=(?P<seq>\d+)(?: thread_id=(?P<tid>\d+))?")
+# scenario phase markers from sc_main; latencies are binned by pop time
+phase_pattern = re.compile(r"\*\*\* Phase (?P<name>\S+) at")
 # track FIFO occupancy prints
 depth_pattern = re.compile(r"\[(?P<which>[TR]X)_FIFO\] depth=(?P<d>\d+)")
 
@@ -15,6 +24,9 @@ if len(sys.argv) != 2:
     print("Usage: python analyze_logs.py <sim_log.txt>  (use '-' for stdin)")
     sys.exit(1)
 
+def time_ns(m):
+    return int(round(float(m.group('time')) * UNIT_NS[m.group('unit')]))
+
 source = sys.stdin if sys.argv[1] == '-' else open(sys.argv[1], 'r', encoding='utf-8')
 
 send_ts = {
@@ -22,6 +34,10 @@ send_ts = {
     'ready': {},
 }
 latencies = defaultdict(list)  # topology -> list of ns
+thread_latencies = defaultdict(lambda: defaultdict(list))  # topology -> thread -> list of ns
+phase_latencies = defaultdict(lambda: defaultdict(list))  # phase -> topology -> list of ns
+phase_order = []
+phase = None
 first_time = None
 last_time = 0
 # track FIFO occupancy prints
@@ -31,19 +47,22 @@ for line in source:
     line = line.strip()
     m = send_pattern.match(line)
     if m:
-        t = int(m.group('time'))
+        t = time_ns(m)
         seq = int(m.group('seq'))
         topo = 'ready' if m.group('tx') else 'credit'
-        send_ts[topo][seq] = t
+        send_ts[topo][seq] = int(m.group('arr')) if m.group('arr') else t
         if first_time is None or t < first_time:
             first_time = t
         last_time = max(last_time, t)
         continue
     mp = pop_pattern.match(line)
     if mp:
-        t = int(mp.group('time'))
+        t = time_ns(mp)
         seq = int(mp.group('seq'))
         qname = mp.group('queue')
+        if '_mesh' in qname:
+            # mesh pairs report their own summary at the end of the run
+            continue
         if qname.startswith('iEP.iEP_front'):
             topo = 'credit'
         elif qname.startswith('iEP_after_RX'):
@@ -54,11 +73,21 @@ for line in source:
         st = send_ts[topo].pop(seq, None)
         if st is not None:
             latencies[topo].append(t - st)
+            if mp.group('tid'):
+                thread_latencies[topo][int(mp.group('tid'))].append(t - st)
+            if phase:
+                phase_latencies[phase][topo].append(t - st)
         if first_time is None or t < first_time:
             first_time = t
         last_time = max(last_time, t)
         continue
 
+    mph = phase_pattern.match(line)
+    if mph:
+        phase = f"{len(phase_order) + 1}:{mph.group('name')}"
+        phase_order.append(phase)
+        continue
+
     md = depth_pattern.search(line)
     if md:
         which = md.group('which')  # 'TX' or 'RX'
@@ -94,9 +123,27 @@ for topo in ('credit', 'ready'):
     bandwidth_MBps = (n * 8) / (sim_duration_ns * 1e-9) / 1e6  # 8 bytes per packet
     print(f"{topo.capitalize()} path:")
     print(f"  Packets received : {n}")
+    p99_latency = sorted(latencies[topo])[min(n - 1, (99 * n) // 100)]
     print(f"  Avg latency      : {avg_latency:.1f} ns")
+    print(f"  P99 latency      : {p99_latency} ns")
     print(f"  Throughput       : {throughput_mpps:.2f} Mpps")
-    print(f"  Bandwidth        : {bandwidth_MBps:.2f} MB/s\n")
+    print(f"  Bandwidth        : {bandwidth_MBps:.2f} MB/s")
+    # per-thread latency shows head-of-line effects between threads
+    for tid in sorted(thread_latencies[topo]):
+        lat = thread_latencies[topo][tid]
+        print(f"  Thread {tid} latency : {sum(lat) / len(lat):.1f} ns (max {max(lat)} ns, n={len(lat)})")
+    print()
+
+# Per-phase latency when the run had several scenario phases
+if len(phase_order) > 1:
+    print("Per-phase latency (by pop time):")
+    for ph in phase_order:
+        for topo in ('credit', 'ready'):
+            lat = sorted(phase_latencies[ph][topo])
+            if lat:
+                p99 = lat[min(len(lat) - 1, (99 * len(lat)) // 100)]
+                print(f"  {ph:16s} {topo:6s} avg {sum(lat) / len(lat):10.1f} ns  p99 {p99:8d} ns  n={len(lat)}")
+    print()
 
 # FIFO occupancy summary
 print(f"Max TX FIFO occupancy : {max_depth['TX']}")
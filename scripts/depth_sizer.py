@@ -0,0 +1,78 @@
+import re, subprocess, sys
+
+SIM = './build/sim'
+ANALYZE = 'scripts/analyze_logs.py'
+SANITY = 'scripts/sanity_ready_loss.py'
+CALIB_LOG = 'depth_calibration.log'
+CONFIRM_LOG = 'depth_confirmation.log'
+
+CONFIRM_REGEX = re.compile(r'Confirm with\s*:\s*(.*)$')
+
+
+def run_sim(args, log_file):
+    print(f"\nRunning {SIM} {' '.join(args)} > {log_file}")
+    with open(log_file, 'w') as f:
+        subprocess.check_call([SIM] + args, stdout=f, stderr=subprocess.STDOUT)
+
+
+def analyze(log_file):
+    """Ready/credit path throughput and latency from analyze_logs.py."""
+    metrics = {}
+    txt = subprocess.check_output(['python3', ANALYZE, log_file], text=True)
+    cur = None
+    for line in txt.splitlines():
+        line = line.strip()
+        if line.startswith('Credit path:'):
+            cur = 'credit'
+        elif line.startswith('Ready path:'):
+            cur = 'ready'
+        elif line.startswith('Avg latency') and cur:
+            metrics[f'{cur}_lat'] = float(line.split(':')[1].split()[0])
+        elif line.startswith('Throughput') and cur:
+            metrics[f'{cur}_mpps'] = float(line.split()[-2])
+            cur = None
+    return metrics
+
+
+def sanity_ok(log_file):
+    return subprocess.call(['python3', SANITY, log_file], stdout=subprocess.DEVNULL) == 0
+
+
+def sizing_block(log_file):
+    """The simulator's sizing report and the options it recommends."""
+    block, args, inside = [], None, False
+    with open(log_file) as f:
+        for line in f:
+            if line.startswith('---- Depth sizing'):
+                inside = True
+            if inside:
+                block.append(line.rstrip())
+                m = CONFIRM_REGEX.search(line)
+                if m:
+                    args = m.group(1).split()
+                    break
+    return block, args
+
+
+def main():
+    extra = sys.argv[1:]   # forwarded to both runs, e.g. --credit-tx=adaptive
+    run_sim(extra + ['--size-depths'], CALIB_LOG)
+    block, args = sizing_block(CALIB_LOG)
+    print('\n'.join(block))
+    if not args:
+        print('Calibration run produced no recommendation')
+        return 1
+
+    run_sim(extra + args, CONFIRM_LOG)
+
+    calib, confirm = analyze(CALIB_LOG), analyze(CONFIRM_LOG)
+    calib_ok, confirm_ok = sanity_ok(CALIB_LOG), sanity_ok(CONFIRM_LOG)
+    print('\nrun           ready_mpps  ready_lat_ns  credit_mpps  lossless')
+    for name, m, ok in (('calibration', calib, calib_ok), ('confirmation', confirm, confirm_ok)):
+        print(f"{name:12s} {m.get('ready_mpps', 0):11.2f} {m.get('ready_lat', 0):13.1f}"
+              f" {m.get('credit_mpps', 0):12.2f}  {'yes' if ok else 'NO'}")
+    return 0 if confirm_ok else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -1,4 +1,6 @@
-import re, subprocess, shutil, os, sys, itertools, textwrap, csv
+import re, subprocess, shutil, os, sys, itertools, textwrap, csv, hashlib, json
+import monte_carlo
+import result_cache
 
 SRC_FILE = 'src/config.h'
 LOG_FILE = 'auto_run.log'
@@ -7,7 +9,41 @@ SANITY = 'scripts/sanity_ready_loss.py'
 
 TX_DEPTHS = [1024, 256, 32, 16, 8, 4, 2, 1]
 RX_DEPTHS = [4,2,1]
-TARGET_RATIO = 0.8  # ready throughput should be this fraction of credit throughput
+# Ready throughput as a fraction of credit throughput.  The hybrid path is
+# bound by its credit window, THREAD_Q_DEPTH credits per thread per round
+# trip through both NoCs: about 0.11 of the direct path at the default NoC
+# settings.  A point passes if it keeps roughly that rate, i.e. the FIFO
+# depths cost nothing on top of the credit loop.
+TARGET_RATIO = 0.1
+# end each run's measurement phase once throughput and latency have converged
+SIM_ARGS = ['--steady']
+# >1: run every point with that many seeds (monte_carlo.py) and report the
+# mean with its 95% confidence half-width
+SEEDS = 1
+
+# --search: instead of the grid above, bisect each parameter to its cheapest
+# value that still meets TARGET_RATIO without drops, taking throughput as
+# monotonic in each parameter.  Parameters are tuned one after the other
+# (coordinate descent) from the most generous point; each step only makes the
+# point stingier, so values found bad earlier stay bad and one pass suffices.
+# Points are passed as runtime options, so the simulator is built once.
+#   name: (sim option, candidates from most generous to cheapest)
+SEARCH_SPACE = {
+    'tx_depth': ('--tx-depth', TX_DEPTHS),
+    'rx_depth': ('--rx-depth', RX_DEPTHS),
+}
+# --search=wide also tunes the per-thread credits and the credit sense window
+WIDE_SPACE = dict(SEARCH_SPACE,
+                  thread_q_depth=('--thread-q-depth', [32, 16, 8, 4, 2, 1]),
+                  credit_window=('--credit-window', [1, 2, 4, 8, 16, 32]))
+
+# Points whose ratio the credit-loop model (build/sim --predict) puts below
+# TARGET_RATIO * PRUNE_MARGIN are not simulated.  The model ignores TX/RX
+# depths and gives every point of a depth-only grid the same ratio, so only
+# searches over MODEL_PARAMS prune; the others just record the ratio.
+PRUNE_MARGIN = 0.5
+MODEL_PARAMS = ('thread_q_depth', 'credit_window')
+MODEL_REGEX = re.compile(r'^(direct|hybrid)\s+\S+\s+([\d.]+)', re.M)
 
 # Regexes to locate the TX and RX depth constexpr lines in main.cpp
 TX_REGEX = re.compile(r'constexpr unsigned TX_FIFO_DEPTH\s*=\s*(\d+);')
@@ -50,10 +86,10 @@ def build():
     print("Build complete")
 
 
-def run_sim():
+def run_sim(args=SIM_ARGS):
     print("\nRunning simulation...")
     with open(LOG_FILE, 'w') as f:
-        subprocess.check_call(['./build/sim'], stdout=f, stderr=subprocess.STDOUT)
+        subprocess.check_call(['./build/sim'] + args, stdout=f, stderr=subprocess.STDOUT)
     print("Simulation complete")
     
     # Print first few lines of log for debugging
@@ -122,12 +158,7 @@ def sweep():
     print('-'*45)
     for tx, rx in itertools.product(TX_DEPTHS, RX_DEPTHS):
         set_depths(tx, rx)
-        build()
-        run_sim()
-
-        sane = sanity_ok()
-
-        m = analyze() if sane else {}
+        sane, m, ci = measure(SIM_ARGS, prepare=build)   # depth-only: no pruning
 
         if not sane:
             print(f"{tx:8d} {rx:8d}   ---           N/A   DROPPED")
@@ -146,7 +177,10 @@ def sweep():
                         ratio,
                         m.get('max_tx'), m.get('max_rx'),
                         m.get('duty_direct'), m.get('duty_hybrid'),
-                        status))
+                        status, SEEDS,
+                        ci.get('credit_mpps'), ci.get('ready_mpps'),
+                        ci.get('credit_lat'), ci.get('ready_lat'),
+                        m.get('model_ratio')))
 
     # write CSV report
     report_path = 'fifo_sweep_report.csv'
@@ -159,15 +193,148 @@ def sweep():
                          'ratio',
                          'max_tx','max_rx',
                          'duty_direct_%','duty_hybrid_%',
-                         'status'])
+                         'status', 'seeds',
+                         'credit_mpps_ci95','ready_mpps_ci95',
+                         'credit_lat_ci95','ready_lat_ci95',
+                         'model_ratio'])
         for row in results:
             writer.writerow(row)
 
     print(f"\nSweep complete. CSV report written to {report_path}")
 
 
+def model_ratio(args):
+    """Hybrid/direct throughput ratio the credit-loop model predicts
+    (build/sim --predict), or None without a direct estimate."""
+    txt = subprocess.check_output(['./build/sim', '--predict'] + args, text=True)
+    mpps = {path: float(v) for path, v in MODEL_REGEX.findall(txt)}
+    return mpps['hybrid'] / mpps['direct'] if mpps.get('direct') and 'hybrid' in mpps else None
+
+
+def measure(args, prepare=None, prune=False):
+    """(sane, metrics, ci95) of one point.  From the result cache when these
+    sources ran with these options before; otherwise prepare() and run.
+    With prune, the model is asked first, using the binary already built, and
+    a point it rules out is neither prepared nor run (metrics then only hold
+    'pruned').  Pruned points are a prediction, not a result, so they are not
+    cached."""
+    extra = {'tool': 'fifo_tuner', 'seeds': SEEDS}
+    hit = result_cache.lookup(args, extra)
+    if hit is not None:
+        print(f"Cached: {' '.join(args)}")
+        return hit
+    predicted = None
+    if prune:
+        predicted = model_ratio(args)
+        if predicted is not None and predicted < TARGET_RATIO * PRUNE_MARGIN:
+            return True, {'pruned': True, 'model_ratio': predicted}, {}
+    if prepare:
+        prepare()
+    if not prune:
+        predicted = model_ratio(args)
+    ci = {}
+    if SEEDS > 1:
+        stats, drops = monte_carlo.run_seeds(args, SEEDS)
+        sane = drops == 0
+        m = {k: v[0] for k, v in stats.items()} if sane else {}
+        ci = {k: v[1] for k, v in stats.items()}
+    else:
+        run_sim(args)
+        sane = sanity_ok()
+        m = analyze() if sane else {}
+    m['model_ratio'] = predicted
+    result_cache.store(args, (sane, m, ci), extra)
+    return sane, m, ci
+
+
+def config_hash(point):
+    """Key of one search point: its parameters and everything else a run uses."""
+    cfg = {'point': point, 'sim_args': SIM_ARGS, 'seeds': SEEDS}
+    return hashlib.sha1(json.dumps(cfg, sort_keys=True).encode()).hexdigest()[:16]
+
+
+def evaluate(point, space, cache, runs, prepare, prune):
+    """(ok, ratio, metrics) of one point, simulated once per configuration."""
+    key = config_hash(point)
+    if key in cache:
+        return cache[key]
+    args = SIM_ARGS + [f'{space[name][0]}={value}' for name, value in point.items()]
+    sane, m, ci = measure(args, prepare, prune)
+
+    ratio = m['ready_mpps'] / m['credit_mpps'] if m.get('credit_mpps') else 0.0
+    ok = sane and 'ready_mpps' in m and ratio >= TARGET_RATIO
+    status = ('DROP' if not sane else 'PRUNED' if m.get('pruned') else
+              'PARSE_ERR' if 'ready_mpps' not in m else 'OK' if ok else 'FAIL')
+    print(' '.join(f'{name}={value}' for name, value in point.items()) + f'   ratio {ratio:5.2f} {status}')
+    runs.append((dict(point), m, ci, ratio, status))
+    cache[key] = (ok, ratio, m)
+    return cache[key]
+
+
+def bisect(point, name, space, cache, runs, prepare, prune):
+    """Cheapest candidate of 'name' that still passes with the rest of 'point'
+    fixed; the current value must pass."""
+    values = space[name][1]
+    good, bad = values.index(point[name]), len(values)
+    while bad - good > 1:
+        mid = (good + bad) // 2
+        trial = dict(point, **{name: values[mid]})
+        if evaluate(trial, space, cache, runs, prepare, prune)[0]:
+            good = mid
+        else:
+            bad = mid
+    return values[good]
+
+
+def search(space):
+    cache, runs, built = {}, [], []
+    def build_once():   # only points missing from the result cache need the binary
+        if not built:
+            build()
+            built.append(True)
+
+    # the points differ in runtime options only, so the one binary answers
+    # the model for all of them and a pruned point costs no build
+    prune = any(name in MODEL_PARAMS for name in space)
+    if prune:
+        build_once()
+
+    point = {name: values[0] for name, (_, values) in space.items()}
+    ok, _, m = evaluate(point, space, cache, runs, build_once, prune)
+    if not ok:
+        print(f"\nTARGET_RATIO {TARGET_RATIO} is not met even at the most generous point"
+              + (f" (model ratio {m['model_ratio']:.2f})" if m.get('pruned') else ''))
+    else:
+        for name in space:
+            point[name] = bisect(point, name, space, cache, runs, build_once, prune)
+
+    grid = 1
+    for _, values in space.values():
+        grid *= len(values)
+    print(f"\nSearch: {len(runs)} runs (grid: {grid})")
+    print('Result: ' + ' '.join(f'{name}={value}' for name, value in point.items()))
+
+    report_path = 'fifo_search_report.csv'
+    print(f"\nWriting results to {report_path}")
+    with open(report_path, 'w', newline='') as csvfile:
+        writer = csv.writer(csvfile)
+        writer.writerow(list(space) + ['credit_mpps', 'credit_lat_ns', 'ready_mpps', 'ready_lat_ns',
+                                       'ratio', 'max_tx', 'max_rx', 'status', 'seeds',
+                                       'credit_mpps_ci95', 'ready_mpps_ci95', 'model_ratio'])
+        for p, m, ci, ratio, status in runs:
+            writer.writerow([p[name] for name in space] +
+                            [m.get('credit_mpps'), m.get('credit_lat'), m.get('ready_mpps'), m.get('ready_lat'),
+                             ratio, m.get('max_tx'), m.get('max_rx'), status, SEEDS,
+                             ci.get('credit_mpps'), ci.get('ready_mpps'), m.get('model_ratio')])
+
+
 def main():
-    sweep()
+    if '--search=wide' in sys.argv[1:]:
+        search(WIDE_SPACE)
+    elif '--search' in sys.argv[1:]:
+        search(SEARCH_SPACE)
+    else:
+        sweep()
 
 if __name__ == '__main__':
     main() 
\ No newline at end of file
@@ -0,0 +1,136 @@
+import csv, re, subprocess, sys
+import result_cache
+
+SIM = './build/sim'
+ANALYZE = 'scripts/analyze_logs.py'
+LOG_FILE = 'load_sweep.log'
+REPORT = 'load_sweep_report.csv'
+
+# Offered load in percent of one packet per cycle.  Dense at the low end,
+# where the hybrid path saturates, and past 100% for the direct path.
+LOADS = [1, 2, 4, 6, 8, 10, 12, 15, 20, 30, 40, 50, 60, 70, 80, 90, 100, 110, 120]
+CLOCK_NS = 100
+
+# A point is below the knee while it accepts at least KNEE_ACCEPT of its
+# offered load and its mean latency stays within KNEE_LAT_X of the lightest
+# load's.  The knee is the last such point.
+KNEE_ACCEPT = 0.95
+KNEE_LAT_X = 3.0
+
+TOPOS = {'credit': ('direct', 'iRC'), 'ready': ('hybrid', 'iRC_tx')}
+OFFERED_REGEX = re.compile(r'Offered / sent : (\d+) / (\d+) packets')
+PHASE_REGEX = re.compile(r'\*\*\* Disabled iEP popping at (\d+) ns')
+
+
+def run_sim(args):
+    with open(LOG_FILE, 'w') as f:
+        subprocess.check_call([SIM] + args, stdout=f, stderr=subprocess.STDOUT)
+
+
+def analyze():
+    """Received packets, throughput and mean/p99 latency per path."""
+    metrics, cur = {}, None
+    txt = subprocess.check_output(['python3', ANALYZE, LOG_FILE], text=True)
+    for line in txt.splitlines():
+        line = line.strip()
+        if line.startswith('Credit path:'):
+            cur = 'credit'
+        elif line.startswith('Ready path:'):
+            cur = 'ready'
+        elif line.startswith('Packets received') and cur:
+            metrics[f'{cur}_pkts'] = int(line.split(':')[1])
+        elif line.startswith('Avg latency') and cur:
+            metrics[f'{cur}_lat'] = float(line.split(':')[1].split()[0])
+        elif line.startswith('P99 latency') and cur:
+            metrics[f'{cur}_p99'] = float(line.split(':')[1].split()[0])
+        elif line.startswith('Throughput') and cur:
+            metrics[f'{cur}_mpps'] = float(line.split()[-2])
+            cur = None
+    return metrics
+
+
+def offered():
+    """Offered packets per iRC (from its traffic report) and the load window."""
+    counts, window_ns, who = {}, None, None
+    with open(LOG_FILE) as f:
+        for line in f:
+            m = PHASE_REGEX.search(line)
+            if m:
+                window_ns = int(m.group(1))
+            if line.startswith('---- iRC'):
+                who = line.split()[1]
+            m = OFFERED_REGEX.search(line)
+            if m and who:
+                counts[who] = int(m.group(1))
+    return counts, window_ns
+
+
+def simulate(args):
+    """(metrics, offered counts, window) of one load point."""
+    run_sim(args)
+    return (analyze(),) + offered()
+
+
+def find_knee(points):
+    """Index of the last point before throughput or latency gives way."""
+    if not points:
+        return None
+    base_lat = points[0]['lat']
+    knee = None
+    for i, p in enumerate(points):
+        if p['accepted'] < KNEE_ACCEPT * p['offered'] or p['lat'] > KNEE_LAT_X * base_lat:
+            break
+        knee = i
+    return knee
+
+
+def main():
+    extra = sys.argv[1:]   # forwarded to every run, e.g. --traffic=onoff --burst=32
+    curves = {topo: [] for topo in TOPOS}
+    for load in LOADS:
+        args = ['--traffic=poisson'] + extra + [f'--load={load}']
+        m, counts, window_ns = result_cache.cached(args, lambda: simulate(args), extra={'tool': 'load_sweep'})
+        for topo, (_, rc) in TOPOS.items():
+            if f'{topo}_pkts' not in m or rc not in counts or not window_ns:
+                print(f'load {load}%: no {topo} data')
+                continue
+            # offered and accepted over the same window: arrivals stop when
+            # popping does, the rest of the run only drains
+            curves[topo].append({
+                'load': load,
+                'offered': counts[rc] / (window_ns * 1e-3),
+                'accepted': m[f'{topo}_pkts'] / (window_ns * 1e-3),
+                'lat': m[f'{topo}_lat'],
+                'p99': m[f'{topo}_p99'],
+            })
+        print(f"load {load:4d}%  direct {m.get('credit_mpps', 0):6.2f} Mpps {m.get('credit_lat', 0):10.1f} ns"
+              f"  hybrid {m.get('ready_mpps', 0):6.2f} Mpps {m.get('ready_lat', 0):12.1f} ns")
+
+    print(f'\nWriting results to {REPORT}')
+    with open(REPORT, 'w', newline='') as f:
+        writer = csv.writer(f)
+        writer.writerow(['topology', 'load_pct', 'offered_mpps', 'accepted_mpps',
+                         'mean_lat_ns', 'p99_lat_ns', 'knee'])
+        for topo, (label, _) in TOPOS.items():
+            knee = find_knee(curves[topo])
+            for i, p in enumerate(curves[topo]):
+                writer.writerow([label, p['load'], f"{p['offered']:.3f}", f"{p['accepted']:.3f}",
+                                 f"{p['lat']:.1f}", f"{p['p99']:.0f}", 'yes' if i == knee else ''])
+
+    link_mpps = 1e3 / CLOCK_NS
+    print('\ntopology  knee_load  accepted_mpps  link_%  mean_lat_ns  p99_lat_ns  saturation_mpps')
+    for topo, (label, _) in TOPOS.items():
+        pts = curves[topo]
+        knee = find_knee(pts)
+        if knee is None:
+            print(f'{label:9s} no knee found (lightest load already saturated)')
+            continue
+        k = pts[knee]
+        sat = max(p['accepted'] for p in pts)
+        print(f"{label:9s} {k['load']:8d}% {k['accepted']:14.2f} {100 * k['accepted'] / link_mpps:7.1f}"
+              f" {k['lat']:12.1f} {k['p99']:11.0f} {sat:16.2f}")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,144 @@
+import math, os, shutil, subprocess, sys, tempfile
+from concurrent.futures import ThreadPoolExecutor
+import result_cache
+
+# Runs the simulator once per seed, K seeds in parallel processes, and reports
+# the mean and 95% confidence interval of every metric analyze_logs.py prints.
+#
+#   python3 scripts/monte_carlo.py [--seeds=K] [--jobs=N] [--first-seed=S] [sim options]
+#
+# Everything else is forwarded to build/sim, e.g. --traffic=poisson --load=40.
+# Each run works in its own temporary directory, so the VCD and module trace
+# files of parallel runs do not collide; file-valued options are made absolute
+# first, so they still name the caller's files (a --checkpoint written there
+# outlives the run).  fifo_tuner.py and noc_tuner.py call
+# run_seeds() when their SEEDS constant is above 1.  Seeds run before with the
+# same options and sources come from result_cache.py.
+
+SIM = os.path.abspath('./build/sim')
+ANALYZE = os.path.abspath('scripts/analyze_logs.py')
+SANITY = os.path.abspath('scripts/sanity_ready_loss.py')
+
+# options whose value is a path, resolved against the caller's directory
+FILE_OPTIONS = ('--trace=', '--drain-trace=', '--scenario=', '--rerun-file=', '--restore=', '--checkpoint=')
+
+SEEDS = 8
+FIRST_SEED = 1
+JOBS = os.cpu_count() or 1
+
+# two-sided 95% Student t quantiles by degrees of freedom
+T95 = [None, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262,
+       2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093,
+       2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042]
+
+
+def parse(txt):
+    """Metrics from analyze_logs.py output, keyed like the tuners' CSVs."""
+    metrics, cur = {}, None
+    for line in txt.splitlines():
+        line = line.strip()
+        if line.startswith('Credit path:'):
+            cur = 'credit'
+        elif line.startswith('Ready path:'):
+            cur = 'ready'
+        elif line.startswith('Packets received') and cur:
+            metrics[f'{cur}_pkts'] = int(line.split(':')[1])
+        elif line.startswith('Avg latency') and cur:
+            metrics[f'{cur}_lat'] = float(line.split(':')[1].split()[0])
+        elif line.startswith('P99 latency') and cur:
+            metrics[f'{cur}_p99'] = float(line.split(':')[1].split()[0])
+        elif line.startswith('Throughput') and cur:
+            metrics[f'{cur}_mpps'] = float(line.split()[-2])
+            cur = None
+        elif line.startswith('Max TX FIFO'):
+            metrics['max_tx'] = int(line.split(':')[1])
+        elif line.startswith('Max RX FIFO'):
+            metrics['max_rx'] = int(line.split(':')[1])
+        elif line.startswith('Direct bus'):
+            metrics['duty_direct'] = float(line.split(':')[1].strip().rstrip('%'))
+        elif line.startswith('Hybrid bus'):
+            metrics['duty_hybrid'] = float(line.split(':')[1].strip().rstrip('%'))
+    return metrics
+
+
+def absolute(args):
+    """args with the paths of FILE_OPTIONS made absolute."""
+    out = []
+    for arg in args:
+        opt = next((o for o in FILE_OPTIONS if arg.startswith(o)), None)
+        out.append(opt + os.path.abspath(arg[len(opt):]) if opt and len(arg) > len(opt) else arg)
+    return out
+
+
+def run_one(args, seed):
+    """(metrics, sane) of one run with --seed=seed."""
+    args = absolute(args)
+    return result_cache.cached(args + [f'--seed={seed}'], lambda: simulate(args, seed),
+                               extra={'tool': 'monte_carlo'})
+
+
+def simulate(args, seed):
+    work = tempfile.mkdtemp(prefix=f'mc_seed{seed}_')
+    try:
+        os.makedirs(os.path.join(work, 'module_traces'))
+        log = os.path.join(work, 'sim.log')
+        with open(log, 'w') as f:
+            subprocess.check_call([SIM] + args + [f'--seed={seed}'], cwd=work,
+                                  stdout=f, stderr=subprocess.STDOUT)
+        sane = subprocess.call(['python3', SANITY, log], stdout=subprocess.DEVNULL) == 0
+        txt = subprocess.check_output(['python3', ANALYZE, log], text=True)
+        return parse(txt), sane
+    finally:
+        shutil.rmtree(work, ignore_errors=True)
+
+
+def ci95(values):
+    """(mean, 95% half-width); the half-width is None below two samples."""
+    n = len(values)
+    mean = sum(values) / n
+    if n < 2:
+        return mean, None
+    sd = math.sqrt(sum((v - mean) ** 2 for v in values) / (n - 1))
+    t = T95[n - 1] if n - 1 < len(T95) else 1.96
+    return mean, t * sd / math.sqrt(n)
+
+
+def run_seeds(args, seeds=SEEDS, first_seed=FIRST_SEED, jobs=JOBS):
+    """Runs seeds first_seed.. in parallel.  Returns ({metric: (mean, hw, n)},
+    drops) where drops counts runs that failed the ready-path sanity check."""
+    seed_list = list(range(first_seed, first_seed + seeds))
+    with ThreadPoolExecutor(max_workers=jobs) as pool:
+        runs = list(pool.map(lambda s: run_one(args, s), seed_list))
+
+    stats = {}
+    for key in sorted({k for m, _ in runs for k in m}):
+        values = [m[key] for m, _ in runs if key in m]
+        mean, hw = ci95(values)
+        stats[key] = (mean, hw, len(values))
+    return stats, sum(1 for _, sane in runs if not sane)
+
+
+def main():
+    seeds, first_seed, jobs, args = SEEDS, FIRST_SEED, JOBS, []
+    for arg in sys.argv[1:]:
+        if arg.startswith('--seeds='):
+            seeds = int(arg.split('=', 1)[1])
+        elif arg.startswith('--first-seed='):
+            first_seed = int(arg.split('=', 1)[1])
+        elif arg.startswith('--jobs='):
+            jobs = int(arg.split('=', 1)[1])
+        else:
+            args.append(arg)
+
+    print(f"Running {seeds} seeds from {first_seed} ({jobs} parallel): {SIM} {' '.join(args)}")
+    stats, drops = run_seeds(args, seeds, first_seed, jobs)
+    print(f"\n{'metric':14s} {'mean':>12s} {'95% CI':>12s} {'n':>4s}")
+    for key, (mean, hw, n) in stats.items():
+        ci = f'+-{hw:.3f}' if hw is not None else '-'
+        print(f"{key:14s} {mean:12.3f} {ci:>12s} {n:4d}")
+    if drops:
+        print(f"\n{drops} of {seeds} runs dropped ready-path packets")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,103 @@
+import hashlib, json, os
+
+# On-disk cache of simulation results, so sweeps and tuners skip points they
+# have run before.  A result is keyed by the simulator options, the contents
+# of files they name (traces, scenarios), the calling tool, and the build id:
+# a hash of the simulator sources and of the scripts that turn a log into
+# metrics.  Editing config.h, src/ or those scripts starts a fresh set of
+# entries; edits anywhere else keep them.
+#
+# Entries are JSON files under $SIM_CACHE (default .sim_cache/).  SIM_CACHE=off
+# disables the cache; deleting the directory empties it.  Runs that write a
+# file besides their log (OUTPUT_OPTIONS) always run and are never stored.
+
+CACHE_DIR = os.environ.get('SIM_CACHE', '.sim_cache')
+SIM = os.path.abspath('./build/sim')
+SIM_INPUTS = ['Makefile', 'src']
+PARSER_INPUTS = ['scripts/analyze_logs.py', 'scripts/sanity_ready_loss.py']
+OUTPUT_OPTIONS = ('--checkpoint=',)
+
+
+def _files(paths):
+    files = []
+    for path in paths:
+        if os.path.isfile(path):
+            files.append(path)
+        for d, _, names in sorted(os.walk(path)):
+            files += sorted(os.path.join(d, n) for n in names if n.endswith(('.h', '.cpp')))
+    return files
+
+
+def _hash_file(h, path):
+    h.update(path.encode())
+    with open(path, 'rb') as f:
+        h.update(f.read())
+
+
+def build_id():
+    """Hash of everything the binary and the metric parsers are made from."""
+    h = hashlib.sha1()
+    for path in _files(SIM_INPUTS + PARSER_INPUTS):
+        _hash_file(h, path)
+    return h.hexdigest()[:16]
+
+
+def key(args, extra=None):
+    h = hashlib.sha1(build_id().encode())
+    h.update(json.dumps([args, extra], sort_keys=True).encode())
+    for arg in args:
+        path = arg.split('=', 1)[-1]
+        if os.path.isfile(path):
+            _hash_file(h, path)
+    return h.hexdigest()[:24]
+
+
+def binary_current():
+    """False when build/sim is missing or older than one of its sources."""
+    if not os.path.exists(SIM):
+        return False
+    built = os.path.getmtime(SIM)
+    return all(os.path.getmtime(p) <= built for p in _files(SIM_INPUTS))
+
+
+def _writes_files(args):
+    return any(arg.startswith(OUTPUT_OPTIONS) for arg in args)
+
+
+def lookup(args, extra=None):
+    """The stored result for these options, or None."""
+    if CACHE_DIR == 'off' or _writes_files(args):
+        return None
+    try:
+        with open(os.path.join(CACHE_DIR, key(args, extra) + '.json')) as f:
+            return json.load(f)['result']
+    except (OSError, ValueError, KeyError):
+        return None
+
+
+def store(args, result, extra=None):
+    """Saves a result, unless it may come from a binary older than the sources
+    it would be filed under."""
+    if CACHE_DIR == 'off' or _writes_files(args):
+        return
+    if not binary_current():
+        print('result_cache: build/sim is older than its sources, result not cached')
+        return
+    os.makedirs(CACHE_DIR, exist_ok=True)
+    path = os.path.join(CACHE_DIR, key(args, extra) + '.json')
+    tmp = f'{path}.{os.getpid()}.tmp'
+    with open(tmp, 'w') as f:
+        json.dump({'args': args, 'extra': extra, 'result': result}, f)
+    os.replace(tmp, path)
+
+
+def cached(args, run, extra=None):
+    """run() unless a result for these options is stored.  Results go through
+    JSON, so tuples come back as lists."""
+    hit = lookup(args, extra)
+    if hit is not None:
+        print(f"Cached: {' '.join(args)}")
+        return hit
+    result = run()
+    store(args, result, extra)
+    return result
@@ -43,7 +43,7 @@ with open(logfile, 'r', encoding='utf-8') as f:
                 if m:
                     recv.add(int(m.group(1)))
                     recv_count += 1
-        elif 'AXI_NOC' in line and 'DROPPED seq_num=' in line:
+        elif ('AXI_NOC' in line or '[TX]' in line) and 'DROPPED seq_num=' in line:
             idx = line.find('DROPPED seq_num=')
             if idx != -1:
                 rest = line[idx+16:]
@@ -0,0 +1,160 @@
+#include "arbiter.h"
+#include "checkpoint.h"
+
+int RoundRobinArbiter::pick(const std::vector<bool>& req, const std::vector<uint64_t>&)
+{
+    for (unsigned k = 0; k < N; ++k)
+    {
+        unsigned i = (next + k) % N;
+        if (req[i])
+        {
+            next = (i + 1) % N;
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void RoundRobinArbiter::save(std::ostream& os) const
+{
+    ckpt_save(os, next);
+}
+
+void RoundRobinArbiter::load(std::istream& is)
+{
+    ckpt_load(is, next);
+}
+
+int OldestFirstArbiter::pick(const std::vector<bool>& req, const std::vector<uint64_t>& stamp)
+{
+    int best = -1;
+    for (unsigned i = 0; i < N; ++i)
+    {
+        if (req[i] && (best < 0 || stamp[i] < stamp[best]))
+            best = static_cast<int>(i);
+    }
+    return best;
+}
+
+WeightedRoundRobinArbiter::WeightedRoundRobinArbiter(unsigned n, const std::vector<unsigned>& weights)
+    : Arbiter(n), weight(n, 1)
+{
+    for (unsigned i = 0; i < n && i < weights.size(); ++i)
+        weight[i] = weights[i] ? weights[i] : 1;
+    left = weight[0];
+}
+
+int WeightedRoundRobinArbiter::pick(const std::vector<bool>& req, const std::vector<uint64_t>&)
+{
+    // stay on the current requester while it has grants left this round
+    if (left > 0 && req[cur])
+    {
+        left--;
+        return static_cast<int>(cur);
+    }
+    for (unsigned k = 1; k <= N; ++k)
+    {
+        unsigned i = (cur + k) % N;
+        if (req[i])
+        {
+            cur = i;
+            left = weight[i] - 1;
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void WeightedRoundRobinArbiter::save(std::ostream& os) const
+{
+    ckpt_save(os, cur, left);
+}
+
+void WeightedRoundRobinArbiter::load(std::istream& is)
+{
+    ckpt_load(is, cur, left);
+}
+
+DeficitRoundRobinArbiter::DeficitRoundRobinArbiter(unsigned n, const std::vector<unsigned>& quanta)
+    : Arbiter(n), quantum(n, 1), deficit(n, 0)
+{
+    for (unsigned i = 0; i < n && i < quanta.size(); ++i)
+        quantum[i] = quanta[i] ? quanta[i] : 1;
+}
+
+int DeficitRoundRobinArbiter::pick(const std::vector<bool>& req, const std::vector<uint64_t>&)
+{
+    for (unsigned k = 0; k <= N; ++k)
+    {
+        if (!req[cur])
+        {
+            deficit[cur] = 0;
+        }
+        else
+        {
+            if (!visited)
+            {
+                deficit[cur] += quantum[cur];
+                visited = true;
+            }
+            if (deficit[cur] >= 1)
+            {
+                deficit[cur]--;
+                return static_cast<int>(cur);
+            }
+        }
+        cur = (cur + 1) % N;
+        visited = false;
+    }
+    return -1;
+}
+
+void DeficitRoundRobinArbiter::save(std::ostream& os) const
+{
+    ckpt_save(os, deficit, cur, visited);
+}
+
+void DeficitRoundRobinArbiter::load(std::istream& is)
+{
+    ckpt_load(is, deficit, cur, visited);
+}
+
+StrictPriorityArbiter::StrictPriorityArbiter(unsigned n, const std::vector<unsigned>& priorities)
+    : Arbiter(n), prio(n)
+{
+    // priorities that are all equal (such as the all-ones RC_WEIGHTS default)
+    // rank nothing and would hand every tie to index 0 forever
+    bool ranked = false;
+    for (unsigned i = 1; i < n && i < priorities.size(); ++i)
+        ranked = ranked || priorities[i] != priorities[0];
+    for (unsigned i = 0; i < n; ++i)
+        prio[i] = ranked && i < priorities.size() ? priorities[i] : n - i;
+}
+
+int StrictPriorityArbiter::pick(const std::vector<bool>& req, const std::vector<uint64_t>&)
+{
+    int best = -1;
+    for (unsigned i = 0; i < N; ++i)
+    {
+        if (req[i] && (best < 0 || prio[i] > prio[best]))
+            best = static_cast<int>(i);
+    }
+    return best;
+}
+
+Arbiter* make_arbiter(const std::string& kind, unsigned n, const std::vector<unsigned>& weights)
+{
+    if (kind == "rr")
+        return new RoundRobinArbiter(n);
+    if (kind == "oldest")
+        return new OldestFirstArbiter(n);
+    if (kind == "ocf")
+        return new OldestFirstArbiter(n, "ocf");
+    if (kind == "wrr")
+        return new WeightedRoundRobinArbiter(n, weights);
+    if (kind == "drr")
+        return new DeficitRoundRobinArbiter(n, weights);
+    if (kind == "sp")
+        return new StrictPriorityArbiter(n, weights);
+    return nullptr;
+}
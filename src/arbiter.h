@@ -0,0 +1,115 @@
+#ifndef ARBITER_H
+#define ARBITER_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// Arbiter: picks one of N requesters per decision.  pick() commits the grant
+// and advances internal state, so call it only when the winner is actually
+// served.  stamp[i] is the arrival time of requester i's head (smaller =
+// older) and is only used by age-based policies.
+// -----------------------------------------------------------------------------
+
+class Arbiter {
+public:
+    explicit Arbiter(unsigned n) : N(n) {}
+    virtual ~Arbiter() {}
+
+    // Returns the granted index, or -1 when nobody requests.
+    virtual int pick(const std::vector<bool>& req, const std::vector<uint64_t>& stamp) = 0;
+    virtual const char* kind() const = 0;
+
+    // Checkpoint of the rotation state (see checkpoint.h); weights are
+    // configuration and are not saved.
+    virtual void save(std::ostream&) const {}
+    virtual void load(std::istream&) {}
+
+protected:
+    const unsigned N;
+};
+
+// Plain round robin: the pointer moves past each winner.
+class RoundRobinArbiter : public Arbiter {
+public:
+    explicit RoundRobinArbiter(unsigned n) : Arbiter(n) {}
+    int pick(const std::vector<bool>& req, const std::vector<uint64_t>& stamp) override;
+    const char* kind() const override { return "rr"; }
+    void save(std::ostream& os) const override;
+    void load(std::istream& is) override;
+
+private:
+    unsigned next = 0;
+};
+
+// Oldest head first; ties go to the lowest index.  Also serves "ocf", which
+// only differs in what the caller stamps, so it reports the name it was built as.
+class OldestFirstArbiter : public Arbiter {
+public:
+    explicit OldestFirstArbiter(unsigned n, const char* name = "oldest") : Arbiter(n), label(name) {}
+    int pick(const std::vector<bool>& req, const std::vector<uint64_t>& stamp) override;
+    const char* kind() const override { return label; }
+
+private:
+    const char* label;
+};
+
+// Weighted round robin: requester i may win up to weight[i] consecutive
+// grants before the pointer moves on.
+class WeightedRoundRobinArbiter : public Arbiter {
+public:
+    WeightedRoundRobinArbiter(unsigned n, const std::vector<unsigned>& weights);
+    int pick(const std::vector<bool>& req, const std::vector<uint64_t>& stamp) override;
+    const char* kind() const override { return "wrr"; }
+    void save(std::ostream& os) const override;
+    void load(std::istream& is) override;
+
+private:
+    std::vector<unsigned> weight;
+    unsigned cur = 0;
+    unsigned left = 0;   // grants remaining for 'cur' in this round
+};
+
+// Deficit round robin: each visit adds quantum[i] to requester i's deficit
+// and every grant costs one beat; the deficit is dropped when i stops
+// requesting, so idle requesters cannot bank bandwidth.
+class DeficitRoundRobinArbiter : public Arbiter {
+public:
+    DeficitRoundRobinArbiter(unsigned n, const std::vector<unsigned>& quanta);
+    int pick(const std::vector<bool>& req, const std::vector<uint64_t>& stamp) override;
+    const char* kind() const override { return "drr"; }
+    void save(std::ostream& os) const override;
+    void load(std::istream& is) override;
+
+private:
+    std::vector<unsigned> quantum;
+    std::vector<unsigned> deficit;
+    unsigned cur = 0;
+    bool visited = false;   // quantum already added for 'cur' this round
+};
+
+// Strict priority: the requester with the highest priority value wins,
+// ties to the lowest index.  Default priorities make index 0 the highest;
+// so do priorities that are all equal, since those give no order.
+class StrictPriorityArbiter : public Arbiter {
+public:
+    StrictPriorityArbiter(unsigned n, const std::vector<unsigned>& priorities);
+    int pick(const std::vector<bool>& req, const std::vector<uint64_t>& stamp) override;
+    const char* kind() const override { return "sp"; }
+
+private:
+    std::vector<unsigned> prio;
+};
+
+// Factory by policy name: "rr", "oldest", "wrr", "drr", "sp", and "ocf"
+// (oldest-credit-first: oldest-first where the caller stamps each requester
+// with the arrival time of its oldest unused credit).  weights are the wrr
+// grants per round, drr quanta or sp priorities; missing ones default to 1
+// (sp: descending by index, also used when all given priorities are equal).
+// Returns nullptr for an unknown name.
+Arbiter* make_arbiter(const std::string& kind, unsigned n, const std::vector<unsigned>& weights = {});
+
+#endif // ARBITER_H
@@ -0,0 +1,40 @@
+#include "checkpoint.h"
+
+#include <fstream>
+
+bool CheckpointIn::read(const std::string& path)
+{
+    std::ifstream f(path);
+    std::string magic;
+    int version = 0;
+    if (!(f >> magic >> version >> time_ticks) || magic != "checkpoint" || version != 1)
+        return false;
+    f.ignore(1);
+    if (!std::getline(f, shape))
+        return false;
+
+    std::string line;
+    while (std::getline(f, line))
+    {
+        const size_t sp = line.find(' ');
+        if (line.empty())
+            continue;
+        lines[line.substr(0, sp)] = sp == std::string::npos ? "" : line.substr(sp + 1);
+    }
+    return true;
+}
+
+std::istringstream CheckpointIn::section(const std::string& name) const
+{
+    auto it = lines.find(name);
+    if (it == lines.end())
+        SC_REPORT_FATAL("checkpoint", ("no state for '" + name + "'").c_str());
+    return std::istringstream(it == lines.end() ? "" : it->second);
+}
+
+void CheckpointIn::check(std::istream& is, const std::string& name)
+{
+    std::string rest;
+    if (is.fail() || (is >> rest))
+        SC_REPORT_FATAL("checkpoint", ("state of '" + name + "' does not match this model").c_str());
+}
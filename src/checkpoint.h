@@ -0,0 +1,150 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <systemc.h>
+#include <deque>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "payloads.h"
+
+// -----------------------------------------------------------------------------
+// Checkpoint: model state as text, one line per object:
+//
+//     <object name> <field> <field> ...
+//
+// Each module writes its own line with ckpt_save() and reads it back with
+// ckpt_load() in the same field order.  A module saves its state and the
+// values of the signals it drives, but not its configuration, so a restored
+// run may use other stall or consumer rates.  Times are kernel ticks
+// (sc_time::value()) and are restored at the same simulated time.
+// -----------------------------------------------------------------------------
+
+template <class T>
+typename std::enable_if<std::is_arithmetic<T>::value>::type ckpt_put(std::ostream& os, const T& v) { os << ' ' << v; }
+template <class T>
+typename std::enable_if<std::is_arithmetic<T>::value>::type ckpt_get(std::istream& is, T& v) { is >> v; }
+
+template <int W> void ckpt_put(std::ostream& os, const sc_uint<W>& v) { os << ' ' << v.to_uint64(); }
+template <int W> void ckpt_get(std::istream& is, sc_uint<W>& v) { uint64_t x = 0; is >> x; v = x; }
+
+inline void ckpt_put(std::ostream& os, const sc_time& t) { os << ' ' << t.value(); }
+inline void ckpt_get(std::istream& is, sc_time& t) { uint64_t x = 0; is >> x; t = sc_time::from_value(x); }
+
+inline void ckpt_put(std::ostream& os, const RawTLP& p) { ckpt_put(os, p.seq_num); ckpt_put(os, p.thread_id); }
+inline void ckpt_get(std::istream& is, RawTLP& p) { ckpt_get(is, p.seq_num); ckpt_get(is, p.thread_id); }
+
+inline void ckpt_put(std::ostream& os, const AxiWord& w) { ckpt_put(os, w.data); ckpt_put(os, w.tlast); }
+inline void ckpt_get(std::istream& is, AxiWord& w) { ckpt_get(is, w.data); ckpt_get(is, w.tlast); }
+
+// RNG engines and distributions have their own text form
+inline void ckpt_put(std::ostream& os, const std::mt19937& r) { os << ' ' << r; }
+inline void ckpt_get(std::istream& is, std::mt19937& r) { is >> r; }
+template <class T> void ckpt_put(std::ostream& os, const std::poisson_distribution<T>& d) { os << ' ' << d; }
+template <class T> void ckpt_get(std::istream& is, std::poisson_distribution<T>& d) { is >> d; }
+
+// Containers: element count, then the elements
+template <class C> void ckpt_put_seq(std::ostream& os, const C& c)
+{
+    ckpt_put(os, c.size());
+    for (const auto& e : c)
+        ckpt_put(os, static_cast<typename C::value_type>(e));
+}
+template <class C> void ckpt_get_seq(std::istream& is, C& c)
+{
+    size_t n = 0;
+    is >> n;
+    c.clear();
+    for (size_t i = 0; i < n && is; ++i) {
+        typename C::value_type e{};
+        ckpt_get(is, e);
+        c.push_back(e);
+    }
+}
+template <class T> void ckpt_put(std::ostream& os, const std::deque<T>& c) { ckpt_put_seq(os, c); }
+template <class T> void ckpt_get(std::istream& is, std::deque<T>& c) { ckpt_get_seq(is, c); }
+template <class T> void ckpt_put(std::ostream& os, const std::vector<T>& c) { ckpt_put_seq(os, c); }
+template <class T> void ckpt_get(std::istream& is, std::vector<T>& c) { ckpt_get_seq(is, c); }
+
+// Signals and output ports: the value driven at the checkpoint.  Restoring
+// writes it back from sc_main, so it is visible at the first edge after.
+template <class T> void ckpt_put(std::ostream& os, const sc_signal<T>& s) { ckpt_put(os, s.read()); }
+template <class T> void ckpt_get(std::istream& is, sc_signal<T>& s) { T v{}; ckpt_get(is, v); s.write(v); }
+template <class T> void ckpt_put(std::ostream& os, const sc_out<T>& p) { ckpt_put(os, p.read()); }
+template <class T> void ckpt_get(std::istream& is, sc_out<T>& p) { T v{}; ckpt_get(is, v); p.write(v); }
+
+// TLP fifos: the packets TlpFifo mirrors, oldest first.  Saving is refused
+// if the mirror disagrees with the fifo; loading writes the packets into the
+// (empty) fifo, where they become visible at the next update.
+inline void ckpt_put(std::ostream& os, const TlpFifo& f)
+{
+    if (f.contents().size() != static_cast<size_t>(f.num_available()))
+        SC_REPORT_FATAL("checkpoint", ("fifo holds " + std::to_string(f.num_available()) + " packets, its mirror "
+                                       + std::to_string(f.contents().size())).c_str());
+    ckpt_put(os, f.contents());
+}
+inline void ckpt_get(std::istream& is, TlpFifo& f)
+{
+    std::deque<RawTLP> items;
+    ckpt_get(is, items);
+    if (f.num_available() != 0 || !f.contents().empty())
+        SC_REPORT_FATAL("checkpoint", "restoring into a non-empty fifo");
+    for (const RawTLP& p : items)
+        if (!f.nb_write(p))
+            SC_REPORT_FATAL("checkpoint", ("saved fifo holds " + std::to_string(items.size())
+                                           + " packets, more than this one can").c_str());
+}
+
+// Arrays of any of the above, element by element
+template <class T, size_t N> void ckpt_put(std::ostream& os, const T (&a)[N])
+{
+    for (const T& e : a)
+        ckpt_put(os, e);
+}
+template <class T, size_t N> void ckpt_get(std::istream& is, T (&a)[N])
+{
+    for (T& e : a)
+        ckpt_get(is, e);
+}
+
+template <class... A> void ckpt_save(std::ostream& os, A&... a) { (ckpt_put(os, a), ...); }
+template <class... A> void ckpt_load(std::istream& is, A&... a) { (ckpt_get(is, a), ...); }
+
+// A checkpoint file read back by object name.
+class CheckpointIn {
+public:
+    // Reads 'path'; false if it cannot be opened or is not a checkpoint.
+    bool read(const std::string& path);
+    bool has(const std::string& name) const { return lines.count(name) > 0; }
+    // Fields of 'name'; fatal if the checkpoint has no such object.
+    std::istringstream section(const std::string& name) const;
+    // Fatal unless every field of 'name' was read.
+    static void check(std::istream& is, const std::string& name);
+
+    uint64_t time_ticks = 0;    // simulated time of the snapshot
+    std::string shape;          // structural parameters, see sc_main
+
+private:
+    std::map<std::string, std::string> lines;
+};
+
+// One object's line, "<name> <fields>", and reading it back in field order.
+template <class... A> void ckpt_save_line(std::ostream& os, const std::string& name, A&... a)
+{
+    os << name;
+    ckpt_save(os, a...);
+    os << '\n';
+}
+template <class... A> void ckpt_load_line(const CheckpointIn& ck, const std::string& name, A&... a)
+{
+    std::istringstream is = ck.section(name);
+    ckpt_load(is, a...);
+    CheckpointIn::check(is, name);
+}
+
+#endif // CHECKPOINT_H
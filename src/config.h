@@ -1,6 +1,9 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <string>
+#include <vector>
+
 // -----------------------------------------------------------------------------
 // Central build-time configuration (all sizes / latencies in one place)
 // -----------------------------------------------------------------------------
@@ -9,6 +12,15 @@ constexpr unsigned TX_FIFO_DEPTH   = 24;   // entries (24 packets @ 64-bit)
 constexpr unsigned RX_FIFO_DEPTH   = 2;   // entries
 constexpr unsigned THREAD_Q_DEPTH = 8;   // per-thread depth inside iEP/FrontEnd
 const unsigned CREDIT_SENSE_WINDOW = 8; // can be tuned – equal to Threaded FIFO depth
+
+// Adaptive credit coalescing in CreditTx (see modules.h); off keeps the
+// fixed CREDIT_SENSE_WINDOW policy as the reference.  Runtime: --credit-tx
+constexpr bool     CREDIT_TX_ADAPTIVE    = false;
+constexpr unsigned CREDIT_TX_URGENT      = THREAD_Q_DEPTH / 2;  // per-thread credits that force a beat
+constexpr unsigned CREDIT_TX_IDLE_CYCLES = 16;  // quiet link: send the first credit at once
+constexpr unsigned CREDIT_TX_MIN_WINDOW  = 1;
+constexpr unsigned CREDIT_TX_MAX_WINDOW  = 16;
+static_assert(CREDIT_TX_MIN_WINDOW > 0 && CREDIT_TX_MIN_WINDOW <= CREDIT_TX_MAX_WINDOW, "bad credit window range");
 constexpr unsigned sim_time_in_us = 10000;  // total simulation duration
 
 constexpr unsigned DATA_NOC_LATENCY = 100;
@@ -21,9 +33,190 @@ constexpr unsigned NOC_PATTERN_LEN = 100; // resolution (cycles)
 static_assert(DATA_NOC_STALL_PCT < 100, "data NOC stall percentage must be <100");
 static_assert(CREDIT_NOC_STALL_PCT < 100, "credit NOC stall percentage must be <100");
 
+// Reverse traffic from iEP_after_RX toward iRC_tx, in percent of link
+// cycles.  It shares the CNOC and credits ride in its spare bits; 0 keeps a
+// dedicated credit-only CNOC.  Runtime: --reverse-load=<pct>
+constexpr unsigned REVERSE_LOAD_PCT = 0;
+static_assert(REVERSE_LOAD_PCT <= 100, "reverse load is a percentage");
+
+// Baseline for piggybacking: carry the reverse traffic on its own link
+// (RNOC, same latency and stall rate as the CNOC) and keep the CNOC for
+// credits only.  Runtime: --reverse-cnoc=shared|dedicated
+constexpr bool REVERSE_DEDICATED_CNOC = false;
+
+// Credit return bus width mode: count mode lets CreditRx hand a whole CNOC
+// beat to iRC_tx in one cycle instead of one pulse per thread per cycle;
+// pulse mode stays the default.  Runtime: --credit-bus=pulse|count
+constexpr bool CREDIT_COUNT_BUS = false;
+// Pulse mode only: merge new credit beats into CreditRx's running counters
+// instead of refusing them until the last beat is unrolled (off: refuse).
+// Runtime: --credit-rx=block|merge
+constexpr bool CREDIT_RX_MERGE = false;
+
+// InitFC: at link-up each Threaded_Queue advertises its full capacity in a
+// single credit message instead of ramping up one credit per cycle (off: ramp).
+// Runtime: --init-fc=on|off
+constexpr bool INIT_FC_ENABLE = false;
+
+// Shared endpoint buffer pool for iEP/iEP_after_RX: each thread is guaranteed
+// EP_POOL_MIN_PER_THREAD entries and borrows from EP_POOL_SHARED beyond that.
+// Credits are only advertised for reserved space, so they never over-promise.
+constexpr bool     EP_SHARED_POOL         = false;
+constexpr unsigned EP_POOL_MIN_PER_THREAD = 2;
+constexpr unsigned EP_POOL_SHARED         = 12;
+static_assert(!EP_SHARED_POOL || EP_POOL_MIN_PER_THREAD + EP_POOL_SHARED > 0, "shared pool needs entries");
+
+// Early credit release: RX (CreditedRxFIFO) grants iRC_tx credits for its own
+// RX_EARLY_PER_THREAD-deep per-thread lanes and keeps a local credit loop to
+// iEP_after_RX, instead of the end-to-end iEP credits.  Shared-FIFO path only.
+constexpr bool     RX_EARLY_CREDIT     = false;
+constexpr unsigned RX_EARLY_PER_THREAD = 8;
+static_assert(!RX_EARLY_CREDIT || 3 * RX_EARLY_PER_THREAD <= TX_FIFO_DEPTH,
+              "TX FIFO must hold every RX credit iRC_tx can be granted");
+
+// Per-thread virtual output queues in SimpleTxFIFO (same TX_FIFO_DEPTH total);
+// the next beat is picked by TX_VOQ_ARBITER: "rr", "oldest" or "wrr".
+constexpr bool        TX_VOQ_ENABLE     = false;
+constexpr const char* TX_VOQ_ARBITER    = "rr";
+constexpr unsigned    TX_VOQ_WEIGHTS[3] = {1, 1, 1};   // wrr grants per round, per thread
+
+// Virtual-channel data path: TX, AXI_NOC and RX keep one lane per thread with a
+// per-lane ready and round-robin VC arbitration at each stage, so a congested
+// thread cannot head-of-line block the others.  TX lanes split the TX depth,
+// RX lanes take the RX depth each and every NoC lane reserves a thread queue's
+// depth of egress buffer (GlobalConfig::tx_depth/rx_depth/thread_q_depth).
+constexpr bool     DATA_NOC_VC_MODE  = false;
+static_assert(!(DATA_NOC_VC_MODE && RX_EARLY_CREDIT), "early credit release needs the shared-FIFO RX");
+
+// Credit-flow-controlled data NoC: DATA_NOC_LATENCY is split into
+// CREDITED_NOC_HOPS hops, each with its own HOP_BUF-deep buffer and a credit
+// counter whose credits return after CREDIT_LAT cycles.  The default buffer
+// covers one hop's credit round trip, so every hop can run at full rate.
+constexpr bool     DATA_NOC_CREDITED       = false;
+constexpr unsigned CREDITED_NOC_HOPS       = 4;
+constexpr unsigned CREDITED_NOC_CREDIT_LAT = DATA_NOC_LATENCY / CREDITED_NOC_HOPS;
+constexpr unsigned CREDITED_NOC_HOP_BUF    = DATA_NOC_LATENCY / CREDITED_NOC_HOPS + CREDITED_NOC_CREDIT_LAT + 2;
+static_assert(CREDITED_NOC_HOPS > 0 && CREDITED_NOC_HOP_BUF > 0, "credited NoC needs hops and buffers");
+static_assert(!(DATA_NOC_VC_MODE && DATA_NOC_CREDITED), "pick one data NoC variant");
+
+// Optional mesh fabric: MESH_PAIRS extra iRC_tx -> TX -> mesh -> RX -> iEP_after_RX
+// loops.  Pair k injects at node k and ejects at node (N-1-k); its credits
+// return over a second mesh.  XY routing is deadlock-free on the mesh only –
+// a torus without VCs can wedge under heavy wrap-around traffic.
+constexpr bool     MESH_ENABLE           = false;
+constexpr unsigned MESH_DIM_X            = 4;
+constexpr unsigned MESH_DIM_Y            = 4;
+constexpr bool     MESH_TORUS            = false;
+constexpr unsigned MESH_PAIRS            = 4;
+constexpr unsigned MESH_LINK_LATENCY     = 10;  // cycles per router-to-router hop
+constexpr unsigned MESH_LINK_STALL_PCT   = 5;
+constexpr unsigned MESH_ROUTER_BUF_DEPTH = 4;   // entries per router input port
+static_assert(MESH_PAIRS <= (MESH_DIM_X * MESH_DIM_Y) / 2, "mesh pairs need distinct source/destination nodes");
+static_assert(MESH_DIM_X * MESH_DIM_Y <= 256, "mesh node id must fit the 8-bit destination field");
+static_assert(MESH_LINK_STALL_PCT < 100, "mesh link stall percentage must be <100");
+
+// iRC thread arbitration: "rr", "wrr", "drr", "sp" or "ocf" (oldest credit
+// first).  Weights are wrr grants / drr quanta / sp priorities per thread.
+// Both can be overridden at runtime, see GlobalConfig.
+constexpr const char* RC_ARBITER    = "rr";
+constexpr unsigned    RC_WEIGHTS[3] = {1, 1, 1};
+
+// Run seed (--seed).  Every random model draws from its own stream, seeded
+// from the run seed and the module name (see seed.h), so one seed always
+// reproduces the same run and different seeds give independent runs.
+constexpr unsigned SIM_SEED = 1;
+
+// Open-loop traffic into both iRCs: "sat" sends whenever a credit is held
+// (saturation); "const", "poisson" and "onoff" (bursts of TRAFFIC_BURST cycles
+// on average) queue arrivals in per-thread source queues instead.  The load is
+// in percent of one packet per cycle, split evenly across the threads unless
+// per-thread loads are given.  "trace" replays a captured file (see
+// TraceTraffic in traffic.h).  Runtime: --traffic, --load, --thread-load,
+// --burst, --trace=<file>
+constexpr const char* TRAFFIC_MODEL       = "sat";
+constexpr unsigned    TRAFFIC_LOAD_PCT    = 60;
+constexpr unsigned    TRAFFIC_BURST       = 16;
+constexpr unsigned    TRAFFIC_SRC_Q_DEPTH = 4096;   // per thread; arrivals beyond are dropped (a trace waits)
+
+// Consumer service behind both iEPs: "full" pops every queue every cycle;
+// "fixed", "exp" (geometric service times) and "limit" (token bucket banking
+// up to DRAIN_BURST pops) serve each queue at DRAIN_RATE_PCT percent of one
+// pop per cycle; "pause" stops for DRAIN_PAUSE_LEN of every DRAIN_PAUSE_PERIOD
+// cycles; "trace" replays recorded grants.  Runtime: --drain, --drain-rate,
+// --drain-rates=a,b,c, --drain-burst, --drain-pause=period,len, --drain-trace
+constexpr const char* DRAIN_MODEL        = "full";
+constexpr unsigned    DRAIN_RATE_PCT     = 100;
+constexpr unsigned    DRAIN_BURST        = THREAD_Q_DEPTH;
+constexpr unsigned    DRAIN_PAUSE_PERIOD = 1000;
+constexpr unsigned    DRAIN_PAUSE_LEN    = 100;
+
+// Scenario phases (see scenario.h).  Without --scenario/--phases the run is
+// "run <sim_time_in_us/2>; drain drained pop=off traffic=off".  A "drained"
+// phase ends after SCENARIO_QUIET_US with no send, delivery or pop on either
+// path, or after SCENARIO_DRAIN_MAX_US at the latest.
+constexpr unsigned SCENARIO_QUIET_US     = 50;
+constexpr unsigned SCENARIO_DRAIN_MAX_US = sim_time_in_us;
+
+// --reruns: the phases again per entry in one process, each run after the
+// first preceded by RERUN_RESET_CYCLES cycles of reset_n low
+constexpr unsigned RERUN_RESET_CYCLES = 4;
+
+// "steady" phases (and --steady, which makes the default measurement phase
+// one) run in STEADY_BATCH_US batches.  Each batch gives one sample of popped
+// Mpps and mean latency per path; after STEADY_WARMUP_BATCHES the phase ends
+// once at least STEADY_MIN_BATCHES agree within STEADY_TOL_PCT (95%
+// confidence, see BatchMeans), or after STEADY_MAX_US.  Batches double in
+// length each time twice STEADY_MIN_BATCHES are kept without agreeing.
+// --steady=<pct> sets the tolerance.
+constexpr unsigned STEADY_BATCH_US       = 50;
+constexpr unsigned STEADY_WARMUP_BATCHES = 4;
+constexpr unsigned STEADY_MIN_BATCHES    = 10;
+constexpr unsigned STEADY_TOL_PCT        = 2;
+constexpr unsigned STEADY_MAX_US         = sim_time_in_us / 2;
+
 // Configuration structure for global settings
 struct GlobalConfig {
     static bool enable_popping;
+
+    // Runtime options (command line --key=value, see main.cpp)
+    static std::string rc_arbiter;               // --rc-arbiter
+    static std::string rc_tx_arbiter;            // --rc-tx-arbiter
+    static std::vector<unsigned> rc_weights;     // --rc-weights=a,b,c
+    static std::vector<unsigned> rc_tx_weights;  // --rc-tx-weights=a,b,c
+    static bool credit_tx_adaptive;              // --credit-tx=fixed|adaptive
+    static bool credit_count_bus;                // --credit-bus=pulse|count
+    static bool credit_rx_merge;                 // --credit-rx=block|merge
+    static bool init_fc;                         // --init-fc=on|off
+    static unsigned reverse_load_pct;            // --reverse-load=<pct>
+    static bool reverse_dedicated;               // --reverse-cnoc=shared|dedicated
+    static std::string traffic;                  // --traffic=sat|const|poisson|onoff
+    static unsigned traffic_load_pct;            // --load=<pct>
+    static std::vector<unsigned> thread_load;    // --thread-load=a,b,c (pct per thread)
+    static unsigned traffic_burst;               // --burst=<cycles>
+    static unsigned seed;                        // --seed
+    static std::string trace_file;               // --trace=<file> (implies --traffic=trace)
+    static std::string drain;                    // --drain=full|fixed|exp|pause|limit|trace
+    static unsigned drain_rate_pct;              // --drain-rate=<pct>
+    static std::vector<unsigned> drain_rates;    // --drain-rates=a,b,c (pct per queue)
+    static unsigned drain_burst;                 // --drain-burst=<pops>
+    static std::vector<unsigned> drain_pause;    // --drain-pause=period,len
+    static std::string drain_trace;              // --drain-trace=<file> (implies --drain=trace)
+    static std::string scenario_file;            // --scenario=<file>
+    static std::string phases;                   // --phases="<phase>; <phase>; ..."
+    static bool steady;                          // --steady[=<tol pct>]
+    static double steady_tol_pct;
+    static std::string reruns;                   // --reruns="<settings>; <settings>; ..."
+    static std::string rerun_file;               // --rerun-file=<file>
+    static std::string checkpoint_file;          // --checkpoint=<file> (after the first phase)
+    static std::string restore_file;             // --restore=<file>
+
+    // Depth overrides (default: the constants above) and the sizing mode
+    static unsigned tx_depth;                    // --tx-depth
+    static unsigned rx_depth;                    // --rx-depth
+    static unsigned thread_q_depth;              // --thread-q-depth
+    static unsigned credit_window;               // --credit-window (CREDIT_SENSE_WINDOW)
+    static bool size_depths;                     // --size-depths
+    static bool predict;                         // --predict (credit_model.h, no simulation)
 };
 
 #endif // CONFIG_H 
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "credit_model.h"
+
+#include <algorithm>
+#include <limits>
+
+// Mean ingress wait of a beat on a NoC whose stall block covers stall_pct of
+// every pattern_len cycles: it lands in the block with that probability and
+// then waits for half of it on average.
+static double stall_wait(unsigned stall_pct, unsigned pattern_len)
+{
+    const double block = (pattern_len * stall_pct) / 100;   // whole cycles, as NocLink
+    return pattern_len ? block * block / (2.0 * pattern_len) : 0.0;
+}
+
+// Mean cycles a random consumer adds per packet over a full-speed one, with
+// each queue fed x / 3 packets per cycle spaced out by iRC's round robin:
+// the geometric service itself plus the Kingman wait behind it.
+static double consumer_hold(const CreditLoopParams& p, double x)
+{
+    if (!p.random_service)
+        return 0.0;
+    double hold = 0.0;
+    for (int t = 0; t < 3; ++t) {
+        const double r = p.service[t];
+        const double rho = x / 3 / r;
+        if (r <= 0.0 || rho >= 1.0)
+            continue;   // this queue is the bottleneck: Little's law covers it
+        hold += (1 / r - 1) + (1 - r) / 2 * rho / (1 - rho) / r;
+    }
+    return hold / 3;
+}
+
+// One path with fixed forward/return loop latencies (cycles) and link rate.
+// 'period' is the stall pattern length when the link has a stall block.
+static PathEstimate estimate_path(const CreditLoopParams& p, double fwd, double ret, double link,
+                                  double period, double cycle_ns)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    const double window = p.thread_q_depth;
+    double rtt0 = fwd + ret;
+
+    // Behind a stall block a credit only makes a trip while the link is
+    // open: when rtt0 exceeds the open part, a thread's whole window crosses
+    // once per pattern and the credits come back during the next block.
+    double per_thread = window / rtt0;
+    bool stall_bound = false;
+    if (period > 0.0) {
+        const double stalled = window * std::max(1.0, link * period / rtt0) / period;
+        stall_bound = stalled < per_thread;
+        per_thread = std::min(per_thread, stalled);
+    }
+
+    bool saturated = false;
+    double credits = 0.0, consumer = 0.0, offered = 0.0, x = 0.0;
+    for (int t = 0; t < 3; ++t) {
+        const double lambda = p.offered[t] < 0 ? inf : p.offered[t];
+        saturated |= p.offered[t] < 0;
+        credits += per_thread;
+        consumer += p.service[t];
+        offered += lambda;
+        x += std::min(lambda, std::min(p.service[t], per_thread));
+    }
+    x = std::min(x, link);
+
+    PathEstimate e;
+    const double cap = std::min(std::min(credits, consumer), link);
+    e.bound = offered < cap ? "offered" : cap == link ? "link" : cap == credits ? "credits" : "consumer";
+    e.mpps = x * 1e3 / cycle_ns;
+    if (x <= 0.0) {
+        e.rtt_ns = e.latency_ns = -1.0;
+        return e;
+    }
+    const double hold = consumer_hold(p, x);
+    fwd += hold;
+    rtt0 += hold;
+
+    // Packets only queue inside the loop at a bottleneck past iRC (including
+    // the stall block holding back a window).  When the credits or iRC's own
+    // packet per cycle are the limit they wait at the source instead, and
+    // spare credits sit in iRC's counters.
+    const bool loop_queue = cap < 1.0 && (cap < credits || stall_bound);
+    if (saturated || offered >= cap) {
+        // every credit is in flight: Little's law over the whole loop
+        const double rtt = loop_queue ? std::max(rtt0, 3 * window / x) : rtt0;
+        e.rtt_ns = rtt * cycle_ns;
+        e.latency_ns = saturated ? (rtt - ret) * cycle_ns : -1.0;   // open loop: queues grow
+    } else {
+        // G/D/1 wait at the bottleneck
+        const double rho = offered / cap;
+        const double wait = p.arrival_idc * rho / (2 * cap * (1 - rho));
+        e.rtt_ns = (rtt0 + (loop_queue ? wait : 0.0)) * cycle_ns;
+        e.latency_ns = (fwd + wait) * cycle_ns;
+    }
+    return e;
+}
+
+CreditLoopEstimate estimate_credit_loop(const CreditLoopParams& p, double cycle_ns)
+{
+    CreditLoopEstimate est;
+    est.path[0] = estimate_path(p, MODEL_DIRECT_FWD_CYCLES, MODEL_DIRECT_RET_CYCLES, 1.0, 0.0, cycle_ns);
+
+    const double data_block = (p.noc_pattern_len * p.data_stall_pct) / 100;
+    const double link = p.noc_pattern_len ? 1.0 - data_block / p.noc_pattern_len : 1.0;
+    const double period = data_block > 0 ? p.noc_pattern_len : 0.0;
+    const double fwd = MODEL_HYBRID_FWD_CYCLES + p.data_noc_latency
+                     + stall_wait(p.data_stall_pct, p.noc_pattern_len);
+    const double hold = p.credit_tx_adaptive ? MODEL_ADAPTIVE_HOLD_CYCLES : p.credit_window / 2.0;
+    const double ret0 = MODEL_HYBRID_RET_CYCLES + p.credit_noc_latency
+                      + stall_wait(p.credit_stall_pct, p.noc_pattern_len) + hold;
+
+    // Pulse mode unrolls a beat one credit per thread per cycle, so the
+    // return grows with the credits per beat, which grow with throughput:
+    // iterate to a fixed point
+    est.path[1] = estimate_path(p, fwd, ret0, link, period, cycle_ns);
+    if (!p.credit_count_bus) {
+        const double beat_cycles = p.credit_tx_adaptive ? MODEL_ADAPTIVE_HOLD_CYCLES : p.credit_window;
+        for (int i = 0; i < 8; ++i) {
+            const double per_beat = std::max(1.0, est.path[1].mpps * cycle_ns / 1e3 / 3 * beat_cycles);
+            est.path[1] = estimate_path(p, fwd, ret0 + (per_beat - 1) / 2, link, period, cycle_ns);
+        }
+    }
+    return est;
+}
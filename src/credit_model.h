@@ -0,0 +1,66 @@
+#ifndef CREDIT_MODEL_H
+#define CREDIT_MODEL_H
+
+// -----------------------------------------------------------------------------
+// CreditLoopModel: closed-form estimate of throughput, credit round trip and
+// end-to-end latency of the direct and hybrid paths, in microseconds instead
+// of a simulation.  Each thread has thread_q_depth credits, so it carries at
+// most thread_q_depth / RTT packets per cycle (window flow control); a path
+// carries the smallest of that, the offered load, the consumer rate and the
+// link (one packet per cycle, on the hybrid path less the data NoC stalls).
+//
+// The unloaded RTT is the registered hops of the loop plus, on the hybrid
+// path, both NoC latencies, the wait for a stall block to end, the credit
+// hold in CreditTx and the CreditRx serialisation.  Behind a data NoC stall
+// block a window of credits crosses at most once per open part of the
+// pattern.  Saturated sources keep every credit in flight, so a path bound
+// past iRC (consumer, stalled data NoC) queues 3 * thread_q_depth / X
+// cycles of packets; when iRC itself or the credits are the limit, spare
+// credits wait at iRC instead.  Open-loop
+// arrivals below the bound wait as in a G/D/1 queue at the bottleneck
+// (Kingman, scaled by the arrivals' index of dispersion).  A random
+// consumer holds each packet a geometric number of cycles, and packets
+// queue behind it in the same way.
+//
+// The model ignores FIFO depths (taken as large enough not to throttle),
+// reverse traffic and the alternative topologies.  Other consumer models
+// are taken at their mean rate.
+// -----------------------------------------------------------------------------
+
+// Registered hops outside the NoCs, in cycles
+constexpr unsigned MODEL_DIRECT_FWD_CYCLES = 2;   // iRC -> Threaded_Queue -> pop
+constexpr unsigned MODEL_DIRECT_RET_CYCLES = 2;   // credit issue -> iRC counter
+constexpr unsigned MODEL_HYBRID_FWD_CYCLES = 6;   // iRC_tx, TX in/out, RX in/out, queue, pop
+constexpr unsigned MODEL_HYBRID_RET_CYCLES = 4;   // credit issue, CreditTx, CreditRx, iRC_tx
+// Adaptive CreditTx on an unobstructed CNOC: its window shrinks to the minimum
+// and a credit leaves within about a cycle
+constexpr double   MODEL_ADAPTIVE_HOLD_CYCLES = 1.0;
+
+struct CreditLoopParams {
+    unsigned thread_q_depth;
+    unsigned data_noc_latency, data_stall_pct;
+    unsigned credit_noc_latency, credit_stall_pct;
+    unsigned noc_pattern_len;
+    unsigned credit_window;           // fixed CreditTx window
+    bool     credit_tx_adaptive;
+    bool     credit_count_bus;        // false: CreditRx unrolls one credit per cycle
+    double   offered[3];              // packets per cycle per thread; < 0 saturated
+    double   arrival_idc;             // index of dispersion: 0 constant, 1 Poisson
+    double   service[3];              // consumer pops per cycle per queue
+    bool     random_service;          // a pop with probability service[] per cycle
+};
+
+struct PathEstimate {
+    double mpps;
+    double rtt_ns;                    // credit round trip under this load
+    double latency_ns;                // creation to pop; < 0 unbounded
+    const char* bound;                // "credits", "link", "consumer" or "offered"
+};
+
+struct CreditLoopEstimate {
+    PathEstimate path[2];             // 0 direct, 1 hybrid
+};
+
+CreditLoopEstimate estimate_credit_loop(const CreditLoopParams& p, double cycle_ns);
+
+#endif // CREDIT_MODEL_H
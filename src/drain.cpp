@@ -0,0 +1,116 @@
+#include "drain.h"
+#include "checkpoint.h"
+
+#include <algorithm>
+
+void DrainModel::save(std::ostream& os) const
+{
+    ckpt_save(os, rng);
+}
+
+void DrainModel::load(std::istream& is)
+{
+    ckpt_load(is, rng);
+}
+
+FixedDrain::FixedDrain(const std::vector<double>& rates, unsigned seed)
+    : DrainModel(rates, seed), acc(rates.size(), 0.0)
+{
+}
+
+unsigned FixedDrain::budget(unsigned q)
+{
+    acc[q] += rate[q];
+    unsigned n = static_cast<unsigned>(acc[q]);
+    acc[q] -= n;
+    return n;
+}
+
+void FixedDrain::save(std::ostream& os) const
+{
+    DrainModel::save(os);
+    ckpt_save(os, acc);
+}
+
+void FixedDrain::load(std::istream& is)
+{
+    DrainModel::load(is);
+    ckpt_load(is, acc);
+}
+
+PauseDrain::PauseDrain(unsigned p, unsigned l)
+    : DrainModel(std::vector<double>(3, 1.0), 0), period(std::max(1u, p)), len(std::min(l, period))
+{
+    for (double& r : rate)
+        r = 1.0 - static_cast<double>(len) / period;
+}
+
+void PauseDrain::save(std::ostream& os) const
+{
+    ckpt_save(os, phase);
+}
+
+void PauseDrain::load(std::istream& is)
+{
+    ckpt_load(is, phase);
+}
+
+LimitDrain::LimitDrain(const std::vector<double>& rates, unsigned burst)
+    : DrainModel(rates, 0), tokens(rates.size(), 0.0), depth(std::max(1u, burst))
+{
+}
+
+unsigned LimitDrain::budget(unsigned q)
+{
+    tokens[q] = std::min(depth, tokens[q] + rate[q]);
+    return static_cast<unsigned>(tokens[q]);
+}
+
+void LimitDrain::save(std::ostream& os) const
+{
+    ckpt_save(os, tokens);
+}
+
+void LimitDrain::load(std::istream& is)
+{
+    ckpt_load(is, tokens);
+}
+
+TraceDrain::TraceDrain(const std::string& path, double cycle_ns)
+    : DrainModel(std::vector<double>(3, 0.0), 0), reader(path, cycle_ns), due(3, 0)
+{
+}
+
+void TraceDrain::tick()
+{
+    std::fill(due.begin(), due.end(), 0u);
+    reader.take(cycle++, due);
+}
+
+void TraceDrain::save(std::ostream& os) const
+{
+    ckpt_save(os, cycle, due);
+    reader.save(os);
+}
+
+void TraceDrain::load(std::istream& is)
+{
+    ckpt_load(is, cycle, due);
+    reader.load(is);
+}
+
+DrainModel* make_drain(const std::string& kind, const std::vector<double>& rates, unsigned seed,
+                       unsigned burst, unsigned period, unsigned len)
+{
+    if (kind == "full")
+        return new FullDrain();
+    if (kind == "fixed")
+        return new FixedDrain(rates, seed);
+    if (kind == "exp")
+        return new ExpDrain(rates, seed);
+    if (kind == "pause")
+        return new PauseDrain(period, len);
+    if (kind == "limit")
+        return new LimitDrain(rates, burst);
+    return nullptr;
+}
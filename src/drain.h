@@ -0,0 +1,132 @@
+#ifndef DRAIN_H
+#define DRAIN_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "traffic.h"
+
+// -----------------------------------------------------------------------------
+// DrainModel: consumer service behind an iEP.  Each cycle the popper calls
+// tick() once and then budget(q) for every queue; budget(q) is how many
+// packets the consumer may take from queue q in that cycle, and used(q, n)
+// reports how many it took.  Grants the queue cannot use are lost (the
+// consumer polled and found nothing) unless the model banks them.  rates are
+// mean pops per cycle, one per queue.
+// -----------------------------------------------------------------------------
+
+class DrainModel {
+public:
+    DrainModel(const std::vector<double>& rates, unsigned seed) : rate(rates), rng(seed) {}
+    virtual ~DrainModel() {}
+
+    virtual void tick() {}
+    virtual unsigned budget(unsigned q) = 0;
+    virtual void used(unsigned, unsigned) {}
+    virtual const char* kind() const = 0;
+    virtual void report(std::ostream&) const {}
+
+    // Checkpoint of the running state (see checkpoint.h); rates are
+    // configuration and are not saved.
+    virtual void save(std::ostream& os) const;
+    virtual void load(std::istream& is);
+
+protected:
+    std::vector<double> rate;
+    std::mt19937 rng;
+};
+
+// One pop per queue per cycle: the consumer is never the bottleneck.
+class FullDrain : public DrainModel {
+public:
+    FullDrain() : DrainModel(std::vector<double>(3, 1.0), 0) {}
+    unsigned budget(unsigned) override { return 1; }
+    const char* kind() const override { return "full"; }
+};
+
+// Deterministic service at rate[q] (fractional accumulator per queue).
+class FixedDrain : public DrainModel {
+public:
+    FixedDrain(const std::vector<double>& rates, unsigned seed);
+    unsigned budget(unsigned q) override;
+    const char* kind() const override { return "fixed"; }
+    void save(std::ostream& os) const override;
+    void load(std::istream& is) override;
+
+private:
+    std::vector<double> acc;
+};
+
+// Memoryless service: each cycle a pop with probability rate[q], i.e.
+// geometric (discrete exponential) service times.
+class ExpDrain : public DrainModel {
+public:
+    ExpDrain(const std::vector<double>& rates, unsigned seed) : DrainModel(rates, seed) {}
+    unsigned budget(unsigned q) override { return u(rng) < rate[q] ? 1 : 0; }
+    const char* kind() const override { return "exp"; }
+
+private:
+    std::uniform_real_distribution<double> u{0.0, 1.0};
+};
+
+// Full speed except for a 'len'-cycle pause every 'period' cycles on all
+// queues, e.g. a consumer that stops for housekeeping.
+class PauseDrain : public DrainModel {
+public:
+    PauseDrain(unsigned period, unsigned len);
+    void tick() override { phase = (phase + 1) % period; }
+    unsigned budget(unsigned) override { return phase < len ? 0 : 1; }
+    const char* kind() const override { return "pause"; }
+    void save(std::ostream& os) const override;
+    void load(std::istream& is) override;
+
+private:
+    unsigned period, len;
+    unsigned phase = 0;
+};
+
+// Token bucket per queue: refills at rate[q] and banks up to 'burst' unused
+// pops, so after an idle spell the consumer may briefly exceed its rate.
+class LimitDrain : public DrainModel {
+public:
+    LimitDrain(const std::vector<double>& rates, unsigned burst);
+    unsigned budget(unsigned q) override;
+    void used(unsigned q, unsigned n) override { tokens[q] -= n; }
+    const char* kind() const override { return "limit"; }
+    void save(std::ostream& os) const override;
+    void load(std::istream& is) override;
+
+private:
+    std::vector<double> tokens;
+    double depth;
+};
+
+// Replay of recorded consumer grants: each "<time> <thread_id> <count>"
+// record lets queue thread_id-1 pop up to count packets at that cycle.
+class TraceDrain : public DrainModel {
+public:
+    TraceDrain(const std::string& path, double cycle_ns);
+    bool ok() const { return reader.ok(); }
+    void tick() override;
+    unsigned budget(unsigned q) override { return due[q]; }
+    const char* kind() const override { return "trace"; }
+    void report(std::ostream& os) const override { reader.report(os, cycle); }
+    void save(std::ostream& os) const override;
+    void load(std::istream& is) override;
+
+private:
+    TraceReader reader;
+    uint64_t cycle = 0;
+    std::vector<unsigned> due;
+};
+
+// Factory by model name: "full", "fixed", "exp", "pause" or "limit"
+// ("trace" needs a file, see TraceDrain).  'burst' is the limit bucket depth;
+// period/len shape the pause model.  Returns nullptr for an unknown name.
+DrainModel* make_drain(const std::string& kind, const std::vector<double>& rates, unsigned seed,
+                       unsigned burst, unsigned period, unsigned len);
+
+#endif // DRAIN_H
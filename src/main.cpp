@@ -1,40 +1,669 @@
 #include <systemc.h>
 #include <iomanip>
 #include <queue>  // For std::queue
+#include <vector>
 #include <iostream>  // For std::cout
 #include <string>
 #include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <fstream>
 #include "payloads.h"
 #include "modules.h"
 #include "config.h"
+#include "scenario.h"
+#include "steady.h"
+#include "seed.h"
+#include "checkpoint.h"
+#include "credit_model.h"
 
 bool GlobalConfig::enable_popping = true;
+std::string GlobalConfig::rc_arbiter = RC_ARBITER;
+std::string GlobalConfig::rc_tx_arbiter = RC_ARBITER;
+std::vector<unsigned> GlobalConfig::rc_weights(std::begin(RC_WEIGHTS), std::end(RC_WEIGHTS));
+std::vector<unsigned> GlobalConfig::rc_tx_weights(std::begin(RC_WEIGHTS), std::end(RC_WEIGHTS));
+bool GlobalConfig::credit_tx_adaptive = CREDIT_TX_ADAPTIVE;
+bool GlobalConfig::credit_count_bus = CREDIT_COUNT_BUS;
+bool GlobalConfig::credit_rx_merge = CREDIT_RX_MERGE;
+bool GlobalConfig::init_fc = INIT_FC_ENABLE;
+unsigned GlobalConfig::reverse_load_pct = REVERSE_LOAD_PCT;
+bool GlobalConfig::reverse_dedicated = REVERSE_DEDICATED_CNOC;
+std::string GlobalConfig::traffic = TRAFFIC_MODEL;
+unsigned GlobalConfig::traffic_load_pct = TRAFFIC_LOAD_PCT;
+std::vector<unsigned> GlobalConfig::thread_load;
+unsigned GlobalConfig::traffic_burst = TRAFFIC_BURST;
+unsigned GlobalConfig::seed = SIM_SEED;
+std::string GlobalConfig::trace_file;
+std::string GlobalConfig::drain = DRAIN_MODEL;
+unsigned GlobalConfig::drain_rate_pct = DRAIN_RATE_PCT;
+std::vector<unsigned> GlobalConfig::drain_rates;
+unsigned GlobalConfig::drain_burst = DRAIN_BURST;
+std::vector<unsigned> GlobalConfig::drain_pause = {DRAIN_PAUSE_PERIOD, DRAIN_PAUSE_LEN};
+std::string GlobalConfig::drain_trace;
+std::string GlobalConfig::scenario_file;
+std::string GlobalConfig::phases;
+bool GlobalConfig::steady = false;
+double GlobalConfig::steady_tol_pct = STEADY_TOL_PCT;
+std::string GlobalConfig::reruns;
+std::string GlobalConfig::rerun_file;
+std::string GlobalConfig::checkpoint_file;
+std::string GlobalConfig::restore_file;
+unsigned GlobalConfig::tx_depth = TX_FIFO_DEPTH;
+unsigned GlobalConfig::rx_depth = RX_FIFO_DEPTH;
+unsigned GlobalConfig::thread_q_depth = THREAD_Q_DEPTH;
+unsigned GlobalConfig::credit_window = CREDIT_SENSE_WINDOW;
+bool GlobalConfig::size_depths = false;
+bool GlobalConfig::predict = false;
+
+// "4,1,1" -> {4, 1, 1}
+static std::vector<unsigned> parse_list(const std::string& s) {
+    std::vector<unsigned> out;
+    size_t pos = 0;
+    while (pos <= s.size()) {
+        size_t comma = s.find(',', pos);
+        if (comma == std::string::npos)
+            comma = s.size();
+        if (comma > pos)
+            out.push_back(static_cast<unsigned>(std::strtoul(s.substr(pos, comma - pos).c_str(), nullptr, 10)));
+        pos = comma + 1;
+    }
+    return out;
+}
+
+// Apply --key=value options on top of the build-time defaults.
+static void parse_args(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string val = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--rc-arbiter")
+            GlobalConfig::rc_arbiter = val;
+        else if (key == "--rc-tx-arbiter")
+            GlobalConfig::rc_tx_arbiter = val;
+        else if (key == "--rc-weights")
+            GlobalConfig::rc_weights = parse_list(val);
+        else if (key == "--rc-tx-weights")
+            GlobalConfig::rc_tx_weights = parse_list(val);
+        else if (key == "--credit-tx" && (val == "fixed" || val == "adaptive"))
+            GlobalConfig::credit_tx_adaptive = val == "adaptive";
+        else if (key == "--credit-bus" && (val == "pulse" || val == "count"))
+            GlobalConfig::credit_count_bus = val == "count";
+        else if (key == "--credit-rx" && (val == "block" || val == "merge"))
+            GlobalConfig::credit_rx_merge = val == "merge";
+        else if (key == "--init-fc" && (val == "on" || val == "off"))
+            GlobalConfig::init_fc = val == "on";
+        else if (key == "--reverse-load")
+            GlobalConfig::reverse_load_pct = std::min(100, std::max(0, std::atoi(val.c_str())));
+        else if (key == "--reverse-cnoc" && (val == "shared" || val == "dedicated"))
+            GlobalConfig::reverse_dedicated = val == "dedicated";
+        else if (key == "--traffic")
+            GlobalConfig::traffic = val;
+        else if (key == "--load")
+            GlobalConfig::traffic_load_pct = std::max(0, std::atoi(val.c_str()));
+        else if (key == "--thread-load")
+            GlobalConfig::thread_load = parse_list(val);
+        else if (key == "--burst")
+            GlobalConfig::traffic_burst = std::max(1, std::atoi(val.c_str()));
+        else if (key == "--seed")
+            GlobalConfig::seed = static_cast<unsigned>(std::strtoul(val.c_str(), nullptr, 10));
+        else if (key == "--trace") {
+            GlobalConfig::traffic = "trace";
+            GlobalConfig::trace_file = val;
+        }
+        else if (key == "--drain")
+            GlobalConfig::drain = val;
+        else if (key == "--drain-rate")
+            GlobalConfig::drain_rate_pct = std::max(0, std::atoi(val.c_str()));
+        else if (key == "--drain-rates")
+            GlobalConfig::drain_rates = parse_list(val);
+        else if (key == "--drain-burst")
+            GlobalConfig::drain_burst = std::max(1, std::atoi(val.c_str()));
+        else if (key == "--drain-pause" && parse_list(val).size() == 2)
+            GlobalConfig::drain_pause = parse_list(val);
+        else if (key == "--drain-trace") {
+            GlobalConfig::drain = "trace";
+            GlobalConfig::drain_trace = val;
+        }
+        else if (key == "--scenario")
+            GlobalConfig::scenario_file = val;
+        else if (key == "--phases")
+            GlobalConfig::phases = val;
+        else if (key == "--steady") {
+            GlobalConfig::steady = true;
+            if (!val.empty())
+                GlobalConfig::steady_tol_pct = std::max(0.01, std::atof(val.c_str()));
+        }
+        else if (key == "--reruns")
+            GlobalConfig::reruns = val;
+        else if (key == "--rerun-file")
+            GlobalConfig::rerun_file = val;
+        else if (key == "--checkpoint")
+            GlobalConfig::checkpoint_file = val;
+        else if (key == "--restore")
+            GlobalConfig::restore_file = val;
+        else if (key == "--tx-depth")
+            GlobalConfig::tx_depth = std::max(1, std::atoi(val.c_str()));
+        else if (key == "--rx-depth")
+            GlobalConfig::rx_depth = std::max(1, std::atoi(val.c_str()));
+        else if (key == "--thread-q-depth")
+            GlobalConfig::thread_q_depth = std::max(1, std::atoi(val.c_str()));
+        else if (key == "--credit-window")
+            GlobalConfig::credit_window = std::max(1, std::atoi(val.c_str()));
+        else if (key == "--size-depths")
+            GlobalConfig::size_depths = true;
+        else if (key == "--predict")
+            GlobalConfig::predict = true;
+        else
+            std::cerr << "Ignoring unknown option " << arg << std::endl;
+    }
+}
+
+// Open-loop traffic model for one iRC (nullptr for "sat").  Per-thread loads
+// win over the total load, which is split evenly across the threads.  Each
+// iRC streams its own copy of a trace file.  The RNG stream is named after
+// the iRC.
+static TrafficModel* make_load_model(const char* who, double cycle_ns)
+{
+    if (GlobalConfig::traffic == "sat")
+        return nullptr;
+    if (GlobalConfig::traffic == "trace") {
+        TraceTraffic* tr = new TraceTraffic(GlobalConfig::trace_file, cycle_ns);
+        if (!tr->ok())
+            SC_REPORT_FATAL(who, ("cannot open trace '" + GlobalConfig::trace_file + "'").c_str());
+        return tr;
+    }
+    std::vector<double> rates(3, GlobalConfig::traffic_load_pct / 300.0);
+    for (unsigned t = 0; t < 3 && t < GlobalConfig::thread_load.size(); ++t)
+        rates[t] = GlobalConfig::thread_load[t] / 100.0;
+    TrafficModel* m = make_traffic(GlobalConfig::traffic, rates, stream_seed(GlobalConfig::seed, who),
+                                   GlobalConfig::traffic_burst);
+    if (!m)
+        SC_REPORT_FATAL(who, ("unknown traffic model '" + GlobalConfig::traffic + "'").c_str());
+    return m;
+}
+
+// Consumer model for one iEP.  Per-queue rates win over the common rate.
+static DrainModel* make_drain_model(const char* who, double cycle_ns)
+{
+    if (GlobalConfig::drain == "trace") {
+        TraceDrain* tr = new TraceDrain(GlobalConfig::drain_trace, cycle_ns);
+        if (!tr->ok())
+            SC_REPORT_FATAL(who, ("cannot open drain trace '" + GlobalConfig::drain_trace + "'").c_str());
+        return tr;
+    }
+    std::vector<double> rates(3, GlobalConfig::drain_rate_pct / 100.0);
+    for (unsigned q = 0; q < 3 && q < GlobalConfig::drain_rates.size(); ++q)
+        rates[q] = GlobalConfig::drain_rates[q] / 100.0;
+    DrainModel* m = make_drain(GlobalConfig::drain, rates, stream_seed(GlobalConfig::seed, who),
+                               GlobalConfig::drain_burst, GlobalConfig::drain_pause[0], GlobalConfig::drain_pause[1]);
+    if (!m)
+        SC_REPORT_FATAL(who, ("unknown drain model '" + GlobalConfig::drain + "'").c_str());
+    return m;
+}
+
+// --size-depths: derive buffer depths from the loop latencies measured in
+// this run.  A loop carrying 'rate' beats per cycle needs rtt * rate credits
+// in flight, shared by three equally active threads; a valid/ready hop
+// needs enough slots to cover its handshake round trip.
+static void report_depth_sizing(const iRC& rc, const iRC& rc_tx, const SimpleTxFIFO* tx,
+                                const SimpleRxFIFO* rx, double cycle_ns)
+{
+    std::cout << "\n---- Depth sizing (calibration) ----\n";
+    if (rc.rtt_min_ns < 0 || rc_tx.rtt_min_ns < 0 || !tx || !rx || tx->hs_min == UINT64_MAX) {
+        std::cout << "Not enough samples (needs the shared-FIFO hybrid path and credit returns)\n";
+        return;
+    }
+    const double direct_rate = 1.0;                                  // iRC sends one packet per cycle
+    const double hybrid_rate = (100.0 - DATA_NOC_STALL_PCT) / 100.0; // data NoC capacity
+    const double rtt_direct = rc.rtt_min_ns / cycle_ns;
+    const double rtt_hybrid = rc_tx.rtt_min_ns / cycle_ns;
+    const unsigned ready_rtt = static_cast<unsigned>(tx->hs_min) + 1;
+
+    const unsigned q_direct = static_cast<unsigned>(std::ceil(rtt_direct * direct_rate / 3));
+    const unsigned q_hybrid = static_cast<unsigned>(std::ceil(rtt_hybrid * hybrid_rate / 3));
+    const unsigned q_full   = std::max(1u, std::max(q_direct, q_hybrid));
+    // every credit iRC_tx holds may land in TX while the NoC is stalled
+    const unsigned tx_nodrop = 3 * q_full;
+    const unsigned tx_full   = static_cast<unsigned>(std::ceil(ready_rtt * hybrid_rate));
+    const unsigned rx_full   = ready_rtt;
+
+    std::cout << "Credit loop RTT    : direct " << rtt_direct << " cycles, hybrid " << rtt_hybrid << " cycles\n";
+    std::cout << "Ready/valid RTT    : " << ready_rtt << " cycles\n";
+    std::cout << "Peak TX / RX occ   : " << tx->max_occ << " / " << rx->max_occ
+              << " (dropped at TX: " << tx->dropped << ")\n";
+    std::cout << "                    non-dropping  full-throughput\n";
+    std::cout << "Threaded_Queue     : " << std::setw(12) << 1 << std::setw(17) << q_full
+              << "  (direct " << q_direct << ", hybrid " << q_hybrid << ")\n";
+    std::cout << "SimpleTxFIFO       : " << std::setw(12) << tx_nodrop << std::setw(17)
+              << std::max(tx_nodrop, tx_full) << "\n";
+    std::cout << "SimpleRxFIFO       : " << std::setw(12) << 1 << std::setw(17) << rx_full << "\n";
+    std::cout << "Confirm with       : --thread-q-depth=" << q_full << " --tx-depth="
+              << std::max(tx_nodrop, tx_full) << " --rx-depth=" << rx_full << "\n";
+}
+
+// Index of dispersion of counts of OnOffTraffic at duty cycle f: a two-state
+// Markov chain whose correlation decays by 1 - p_off - p_on per cycle.
+static double onoff_idc(double f, unsigned burst)
+{
+    if (f <= 0.0 || f >= 1.0)
+        return 0.0;
+    const double b = burst ? burst : 1;
+    const double decay = 1.0 - 1.0 / b - std::min(1.0, f / (b * (1.0 - f)));
+    return (1.0 - f) * (1.0 + decay) / (1.0 - decay);
+}
+
+// Inputs of the credit-loop model from the configuration.  Traces have no
+// rate up front and count as saturated sources / a full consumer.
+static CreditLoopParams credit_loop_params()
+{
+    CreditLoopParams p;
+    p.thread_q_depth = GlobalConfig::thread_q_depth;
+    p.data_noc_latency = DATA_NOC_LATENCY;
+    p.data_stall_pct = DATA_NOC_STALL_PCT;
+    p.credit_noc_latency = CREDIT_NOC_LATENCY;
+    p.credit_stall_pct = CREDIT_NOC_STALL_PCT;
+    p.noc_pattern_len = NOC_PATTERN_LEN;
+    p.credit_window = GlobalConfig::credit_window;
+    p.credit_tx_adaptive = GlobalConfig::credit_tx_adaptive;
+    p.credit_count_bus = GlobalConfig::credit_count_bus;
+    const std::string& drain = GlobalConfig::drain;
+    p.random_service = drain == "exp";
+    double rate_sum = 0.0, idc_sum = 0.0;
+    for (unsigned t = 0; t < 3; ++t) {
+        if (GlobalConfig::traffic == "sat" || GlobalConfig::traffic == "trace")
+            p.offered[t] = -1.0;
+        else
+            p.offered[t] = (t < GlobalConfig::thread_load.size() ? GlobalConfig::thread_load[t]
+                                                                 : GlobalConfig::traffic_load_pct / 3.0) / 100.0;
+        if (GlobalConfig::traffic == "onoff" && p.offered[t] > 0.0) {
+            rate_sum += p.offered[t];
+            idc_sum += p.offered[t] * onoff_idc(p.offered[t], GlobalConfig::traffic_burst);
+        }
+        if (drain == "full" || drain == "trace")
+            p.service[t] = 1.0;
+        else if (drain == "pause")
+            p.service[t] = 1.0 - std::min(1.0, double(GlobalConfig::drain_pause[1]) / std::max(1u, GlobalConfig::drain_pause[0]));
+        else
+            p.service[t] = (t < GlobalConfig::drain_rates.size() ? GlobalConfig::drain_rates[t]
+                                                                 : GlobalConfig::drain_rate_pct) / 100.0;
+    }
+    // the threads' sum disperses as their rate-weighted mean
+    p.arrival_idc = GlobalConfig::traffic == "const" ? 0.0
+                  : GlobalConfig::traffic == "onoff" ? (rate_sum > 0.0 ? idc_sum / rate_sum : 0.0)
+                  : 1.0;
+    return p;
+}
+
+// The model's estimate per path; with 'sim' (Mpps, credit RTT and latency per
+// path, < 0 when not measured) also the measured values and the model error.
+static void report_credit_model(const CreditLoopEstimate& est, const double (*sim)[3] = nullptr)
+{
+    static const char* paths[2] = {"direct", "hybrid"};
+    std::cout << "\n---- Credit-loop model" << (sim ? " vs sim" : "") << " ----\n";
+    std::cout << "path    bound     model_Mpps"
+              << (sim ? "  sim_Mpps  err_%" : "") << "  model_rtt_ns"
+              << (sim ? "  sim_rtt_ns  err_%" : "") << "  model_lat_ns"
+              << (sim ? "  sim_lat_ns  err_%" : "") << "\n";
+    const std::streamsize prec = std::cout.precision();
+    std::cout << std::fixed;
+    auto column = [&](double model, double measured, int width, int digits) {
+        std::cout << std::setprecision(digits) << std::setw(width);
+        if (model < 0)
+            std::cout << "inf";
+        else
+            std::cout << model;
+        if (!sim)
+            return;
+        if (measured < 0) {
+            std::cout << std::setw(width - 2) << "-" << std::setw(7) << "-";
+            return;
+        }
+        std::cout << std::setw(width - 2) << measured << std::setprecision(1) << std::setw(7);
+        if (measured > 0 && model >= 0)
+            std::cout << 100.0 * (model - measured) / measured;
+        else
+            std::cout << "-";
+    };
+    for (int p = 0; p < 2; ++p) {
+        const PathEstimate& e = est.path[p];
+        std::cout << std::left << std::setw(8) << paths[p] << std::setw(8) << e.bound << std::right;
+        column(e.mpps, sim ? sim[p][0] : -1.0, 12, 2);
+        column(e.rtt_ns, sim ? sim[p][1] : -1.0, 14, 1);
+        column(e.latency_ns, sim ? sim[p][2] : -1.0, 14, 1);
+        std::cout << "\n";
+    }
+    std::cout.unsetf(std::ios::fixed);
+    std::cout.precision(prec);
+}
+
+// Cumulative counters sampled at scenario phase boundaries; index 0 is the
+// direct path (iRC -> iEP), 1 the hybrid path (iRC_tx -> iEP_after_RX).
+struct PhaseSample {
+    double   t_us = 0.0;
+    uint64_t sent[2] = {0, 0};
+    uint64_t routed[2] = {0, 0};    // arrived at the iEP
+    uint64_t popped[2] = {0, 0};
+    uint64_t starved[2] = {0, 0};   // summed over the three threads
+    uint64_t window[2] = {0, 0};    // iRC cycles with traffic on
+    uint64_t rtt_samples[2] = {0, 0};
+    double   rtt_sum_ns[2] = {0.0, 0.0};
+    uint64_t lat_samples[2] = {0, 0};   // creation -> pop, when the probes are on
+    double   lat_sum_ns[2] = {0.0, 0.0};
+
+    PhaseSample(const iRC& rc, const iRC& rc_tx, const iEP& ep, const iEP& ep_rx)
+        : t_us(sc_time_stamp().to_seconds() * 1e6) {
+        const iRC* rcs[2] = {&rc, &rc_tx};
+        const iEP* eps[2] = {&ep, &ep_rx};
+        for (int p = 0; p < 2; ++p) {
+            sent[p]    = rcs[p]->pkts_sent;
+            routed[p]  = eps[p]->threaded_queues->pkts_routed;
+            popped[p]  = eps[p]->threaded_queues->pkts_popped;
+            starved[p] = rcs[p]->starved[0] + rcs[p]->starved[1] + rcs[p]->starved[2];
+            window[p]  = rcs[p]->window_cycles;
+            rtt_samples[p] = rcs[p]->rtt_samples;
+            rtt_sum_ns[p]  = rcs[p]->rtt_sum_ns;
+            if (rcs[p]->probe) {
+                lat_samples[p] = rcs[p]->probe->samples;
+                lat_sum_ns[p]  = rcs[p]->probe->sum_ns;
+            }
+        }
+    }
+    uint64_t activity() const { return sent[0] + sent[1] + routed[0] + routed[1] + popped[0] + popped[1]; }
+};
+
+static void report_phase(const std::string& name, const PhaseSample& a, const PhaseSample& b)
+{
+    const double us = b.t_us - a.t_us;
+    std::cout << "\n---- Phase " << name << " (" << a.t_us << " - " << b.t_us << " us) ----\n";
+    std::cout << "path        sent  delivered     popped  popped_Mpps  credit_starved_%\n";
+    const char* label[2] = {"direct", "hybrid"};
+    for (int p = 0; p < 2; ++p) {
+        const uint64_t win = b.window[p] - a.window[p];
+        std::cout << std::left << std::setw(7) << label[p] << std::right
+                  << std::setw(9) << b.sent[p] - a.sent[p]
+                  << std::setw(11) << b.routed[p] - a.routed[p]
+                  << std::setw(11) << b.popped[p] - a.popped[p]
+                  << std::setw(13) << (us > 0 ? (b.popped[p] - a.popped[p]) / us : 0.0);
+        if (win)
+            std::cout << std::setw(18) << 100.0 * (b.starved[p] - a.starved[p]) / (3.0 * win);
+        else
+            std::cout << std::setw(18) << "-";
+        std::cout << "\n";
+    }
+}
+
+// One --reruns entry: counters at the start and end of its phases
+struct RunResult {
+    PhaseSample start, end;
+    double popping_us;   // time with iEP popping on
+};
+
+static void report_reruns(const std::vector<ScenarioRerun>& runs, const std::vector<RunResult>& results)
+{
+    std::cout << "\n---- Re-runs ----\n";
+    std::cout << "run  direct_Mpps  hybrid_Mpps  direct_rtt_ns  hybrid_rtt_ns  direct_lat_ns  hybrid_lat_ns"
+                 "  direct_starved_%  hybrid_starved_%  settings\n";
+    const std::streamsize prec = std::cout.precision();
+    std::cout << std::fixed;
+    for (size_t k = 0; k < results.size(); ++k) {
+        const RunResult& r = results[k];
+        std::cout << std::setw(3) << k << std::setprecision(2);
+        for (int p = 0; p < 2; ++p)
+            std::cout << std::setw(13) << (r.popping_us > 0 ? (r.end.popped[p] - r.start.popped[p]) / r.popping_us : 0.0);
+        std::cout << std::setprecision(1);
+        for (int p = 0; p < 2; ++p) {
+            const uint64_t n = r.end.rtt_samples[p] - r.start.rtt_samples[p];
+            std::cout << std::setw(15) << (n ? (r.end.rtt_sum_ns[p] - r.start.rtt_sum_ns[p]) / n : 0.0);
+        }
+        for (int p = 0; p < 2; ++p) {
+            const uint64_t n = r.end.lat_samples[p] - r.start.lat_samples[p];
+            std::cout << std::setw(15) << (n ? (r.end.lat_sum_ns[p] - r.start.lat_sum_ns[p]) / n : 0.0);
+        }
+        for (int p = 0; p < 2; ++p) {
+            const uint64_t win = r.end.window[p] - r.start.window[p];
+            std::cout << std::setw(18) << (win ? 100.0 * (r.end.starved[p] - r.start.starved[p]) / (3.0 * win) : 0.0);
+        }
+        std::cout << "  " << (runs[k].label.empty() ? "-" : runs[k].label) << "\n";
+    }
+    std::cout.unsetf(std::ios::fixed);
+    std::cout.precision(prec);
+}
+
+// "steady" phase: run STEADY_BATCH_US batches until popped Mpps and mean
+// latency of both paths have converged, or for STEADY_MAX_US at the latest.
+static void run_until_steady(const iEP& ep, const iEP& ep_rx, const LatencyProbe probe[2])
+{
+    const iEP* eps[2] = {&ep, &ep_rx};
+    const double tol = GlobalConfig::steady_tol_pct / 100.0;
+    BatchMeans bm(4, STEADY_WARMUP_BATCHES, STEADY_MIN_BATCHES);   // Mpps, ns per path
+
+    uint64_t popped[2], samples[2];
+    double   sum_ns[2];
+    for (int p = 0; p < 2; ++p) {
+        popped[p]  = eps[p]->threaded_queues->pkts_popped;
+        samples[p] = probe[p].samples;
+        sum_ns[p]  = probe[p].sum_ns;
+    }
+
+    double ran = 0.0;
+    while (!bm.converged(tol) && ran < STEADY_MAX_US) {
+        sc_start(static_cast<double>(STEADY_BATCH_US), SC_US);
+        ran += STEADY_BATCH_US;
+        std::vector<double> batch;
+        for (int p = 0; p < 2; ++p) {
+            const uint64_t n = probe[p].samples - samples[p];
+            batch.push_back((eps[p]->threaded_queues->pkts_popped - popped[p]) / double(STEADY_BATCH_US));
+            batch.push_back(n ? (probe[p].sum_ns - sum_ns[p]) / n : 0.0);
+            popped[p]  = eps[p]->threaded_queues->pkts_popped;
+            samples[p] = probe[p].samples;
+            sum_ns[p]  = probe[p].sum_ns;
+        }
+        bm.add(batch);
+    }
+
+    std::cout << "*** " << (bm.converged(tol) ? "Steady" : "Not steady") << " after " << ran
+              << " us (" << bm.batches() << " batches of " << bm.batch_len() * STEADY_BATCH_US
+              << " us, tol " << GlobalConfig::steady_tol_pct << "%):";
+    const char* label[2] = {"direct", "hybrid"};
+    for (unsigned p = 0; p < 2; ++p)
+        std::cout << " " << label[p] << " " << bm.mean(2 * p) << " +- " << bm.half_width(2 * p)
+                  << " Mpps, " << bm.mean(2 * p + 1) << " +- " << bm.half_width(2 * p + 1) << " ns;";
+    std::cout << " ***" << std::endl;
+}
+
+// Node-side signals of a MeshNoC, one entry per node.
+struct MeshSignals {
+    sc_signal<bool>*    inj_valid;
+    sc_signal<AxiWord>* inj_axi;
+    sc_signal<bool>*    inj_ready;
+    sc_signal<bool>*    ej_valid;
+    sc_signal<AxiWord>* ej_axi;
+    sc_signal<bool>*    ej_ready;
+
+    MeshSignals(MeshNoC& mesh) {
+        const unsigned n = mesh.num_nodes();
+        inj_valid = new sc_signal<bool>[n];
+        inj_axi   = new sc_signal<AxiWord>[n];
+        inj_ready = new sc_signal<bool>[n];
+        ej_valid  = new sc_signal<bool>[n];
+        ej_axi    = new sc_signal<AxiWord>[n];
+        ej_ready  = new sc_signal<bool>[n];
+        for (unsigned i = 0; i < n; ++i) {
+            mesh.inj_valid[i](inj_valid[i]);
+            mesh.inj_axi[i](inj_axi[i]);
+            mesh.inj_ready[i](inj_ready[i]);
+            mesh.ej_valid[i](ej_valid[i]);
+            mesh.ej_axi[i](ej_axi[i]);
+            mesh.ej_ready[i](ej_ready[i]);
+        }
+    }
+};
+
+// One hybrid loop attached to the mesh: data src -> dst, credits dst -> src.
+struct MeshPair {
+    unsigned src, dst;
+    sc_signal<bool>       rc2tx_valid;
+    sc_signal<RawTLP>     rc2tx_tlp;
+    sc_signal<bool>       rx2ep_valid;
+    sc_signal<RawTLP>     rx2ep_tlp;
+    sc_signal<CreditBus>  ep_credit;
+    sc_signal<CreditBus>  rc_credit;
+    sc_signal<bool>       ep2packer_rev_valid, packer2ep_rev_ready, pulser2rc_rev_valid;
+    sc_signal<RawTLP>     ep2packer_rev_tlp, pulser2rc_rev_tlp;
+    iRC*          rc;
+    SimpleTxFIFO* tx;
+    SimpleRxFIFO* rx;
+    iEP*          ep;
+    CreditTx*     packer;
+    CreditRx*     pulser;
+
+    MeshPair(unsigned k, unsigned src_node, unsigned dst_node, sc_clock& clk, sc_signal<bool>& reset_n,
+             MeshSignals& data, MeshSignals& credit) : src(src_node), dst(dst_node) {
+        const std::string sfx = "_mesh" + std::to_string(k);
+        rc = new iRC(("iRC" + sfx).c_str());
+        rc->init_window = GlobalConfig::thread_q_depth;
+        rc->clk(clk);
+        rc->reset_n(reset_n);
+        rc->raw_valid(rc2tx_valid);
+        rc->raw_tlp(rc2tx_tlp);
+        rc->credit_in(rc_credit);
+        rc->rev_valid(pulser2rc_rev_valid);
+        rc->rev_tlp(pulser2rc_rev_tlp);
+
+        tx = new SimpleTxFIFO(("TX" + sfx).c_str(), GlobalConfig::tx_depth);
+        tx->clk(clk);
+        tx->reset_n(reset_n);
+        tx->ingress_valid(rc2tx_valid);
+        tx->ingress_tlp(rc2tx_tlp);
+        tx->egress_valid(data.inj_valid[src]);
+        tx->egress_axi(data.inj_axi[src]);
+        tx->egress_ready(data.inj_ready[src]);
+
+        rx = new SimpleRxFIFO(("RX" + sfx).c_str(), GlobalConfig::rx_depth);
+        rx->clk(clk);
+        rx->reset_n(reset_n);
+        rx->valid_in(data.ej_valid[dst]);
+        rx->axi_in(data.ej_axi[dst]);
+        rx->ready_out(data.ej_ready[dst]);
+        rx->valid_out(rx2ep_valid);
+        rx->tlp_out(rx2ep_tlp);
+
+        ep = new iEP(("iEP" + sfx).c_str(), GlobalConfig::thread_q_depth);
+        ep->clk(clk);
+        ep->reset_n(reset_n);
+        ep->raw_valid(rx2ep_valid);
+        ep->raw_tlp(rx2ep_tlp);
+        ep->credit_out(ep_credit);
+        ep->rev_valid(ep2packer_rev_valid);
+        ep->rev_tlp(ep2packer_rev_tlp);
+        ep->rev_ready(packer2ep_rev_ready);
+
+        packer = new CreditTx(("Credit_packer" + sfx).c_str(), GlobalConfig::credit_window,
+                              GlobalConfig::credit_tx_adaptive);
+        packer->clk(clk);
+        packer->reset_n(reset_n);
+        packer->credit_in(ep_credit);
+        packer->rev_valid_in(ep2packer_rev_valid);
+        packer->rev_tlp_in(ep2packer_rev_tlp);
+        packer->rev_ready_out(packer2ep_rev_ready);
+        packer->valid_out(credit.inj_valid[dst]);
+        packer->axi_out(credit.inj_axi[dst]);
+        packer->ready_in(credit.inj_ready[dst]);
+
+        pulser = new CreditRx(("Credit_Pulser" + sfx).c_str(), GlobalConfig::credit_count_bus,
+                              GlobalConfig::credit_rx_merge);
+        pulser->clk(clk);
+        pulser->reset_n(reset_n);
+        pulser->valid_in(credit.ej_valid[src]);
+        pulser->axi_in(credit.ej_axi[src]);
+        pulser->ready_out(credit.ej_ready[src]);
+        pulser->credit_out(rc_credit);
+        pulser->rev_valid_out(pulser2rc_rev_valid);
+        pulser->rev_tlp_out(pulser2rc_rev_tlp);
+    }
+};
 
 // Top-level sc_main
 int sc_main(int argc, char* argv[]) {
 
-    sc_clock           system_clk("system_clk", 100, SC_NS);  // Single common clock
+    parse_args(argc, argv);
+    std::cout << "*** Seed " << GlobalConfig::seed << " ***" << std::endl;   // reproduce with --seed
+
+    // Checkpoints cover the default topology; the state of the alternative
+    // data paths and the mesh is not saved
+    const bool restoring = !GlobalConfig::restore_file.empty();
+    if ((restoring || !GlobalConfig::checkpoint_file.empty()) &&
+        (DATA_NOC_VC_MODE || DATA_NOC_CREDITED || RX_EARLY_CREDIT || MESH_ENABLE))
+        SC_REPORT_FATAL("checkpoint", "not supported with DATA_NOC_VC_MODE, DATA_NOC_CREDITED, "
+                                      "RX_EARLY_CREDIT or MESH_ENABLE");
+    if ((restoring || !GlobalConfig::checkpoint_file.empty()) &&
+        GlobalConfig::reverse_load_pct > 0 && GlobalConfig::reverse_dedicated)
+        SC_REPORT_FATAL("checkpoint", "not supported with --reverse-cnoc=dedicated");
+    // Re-runs reset the default topology only (see RERUN_RESET_CYCLES)
+    if ((!GlobalConfig::reruns.empty() || !GlobalConfig::rerun_file.empty()) &&
+        (DATA_NOC_VC_MODE || DATA_NOC_CREDITED || RX_EARLY_CREDIT || MESH_ENABLE))
+        SC_REPORT_FATAL("reruns", "not supported with DATA_NOC_VC_MODE, DATA_NOC_CREDITED, "
+                                  "RX_EARLY_CREDIT or MESH_ENABLE");
+    // Early-credit RX lanes are RX_EARLY_PER_THREAD deep, whatever the RX depth
+    if (RX_EARLY_CREDIT && GlobalConfig::rx_depth != RX_FIFO_DEPTH)
+        SC_REPORT_FATAL("depths", "--rx-depth has no effect with RX_EARLY_CREDIT (see RX_EARLY_PER_THREAD)");
+    if (RX_EARLY_CREDIT && 3 * RX_EARLY_PER_THREAD > GlobalConfig::tx_depth)
+        SC_REPORT_FATAL("depths", "TX depth must hold every RX credit iRC_tx can be granted "
+                                  "(3 * RX_EARLY_PER_THREAD)");
+    CheckpointIn restored;
+    if (restoring && !restored.read(GlobalConfig::restore_file))
+        SC_REPORT_FATAL("checkpoint", ("cannot read '" + GlobalConfig::restore_file + "'").c_str());
+
+    // Single common clock.  A restored run resumes at the checkpoint time, so
+    // its first edge is the one the saved run would have seen next.
+    const sc_time clk_period(100, SC_NS);
+    const sc_time resume_at = sc_time::from_value(restored.time_ticks);
+    const uint64_t period_ticks = clk_period.value();
+    const sc_time first_edge =
+        sc_time::from_value((resume_at.value() + period_ticks - 1) / period_ticks * period_ticks);
+    sc_clock           system_clk("system_clk", clk_period, 0.5, first_edge, true);
+
+    // --predict: the credit-loop model only, without simulating
+    if (GlobalConfig::predict) {
+        report_credit_model(estimate_credit_loop(credit_loop_params(), clk_period.to_seconds() * 1e9));
+        return 0;
+    }
     sc_signal<bool>    reset_n;
 
-    sc_signal<sc_uint<3>> credit;  // 3-bit credit bus
+    sc_signal<CreditBus>  credit;  // per-thread credit bus
     sc_signal<bool>    raw_valid;
     sc_signal<RawTLP>  raw_tlp;
+    sc_signal<bool>    rev_valid, rev_ready;   // no reverse traffic on the direct path
+    sc_signal<RawTLP>  rev_tlp;
 
     // Create and connect iRC->iEP topology
-    iRC rc("iRC");
+    iRC rc("iRC", GlobalConfig::rc_arbiter, GlobalConfig::rc_weights);
+    rc.set_traffic(make_load_model("iRC", system_clk.period().to_seconds() * 1e9));
     rc.clk(system_clk);  // Connect RC to common clock
     rc.reset_n(reset_n);
     rc.credit_in(credit);
     rc.raw_valid(raw_valid);
     rc.raw_tlp(raw_tlp);
+    rc.rev_valid(rev_valid);
+    rc.rev_tlp(rev_tlp);
+
+    // In pool mode a queue's link-up window is only its guaranteed share
+    const unsigned pool_min = EP_SHARED_POOL ? EP_POOL_MIN_PER_THREAD : 0;
+    const unsigned pool_shared = EP_SHARED_POOL ? EP_POOL_SHARED : 0;
+    const unsigned ep_init_window = EP_SHARED_POOL ? pool_min : GlobalConfig::thread_q_depth;
+    rc.init_window = ep_init_window;
 
-    iEP ep("iEP", THREAD_Q_DEPTH);
+    iEP ep("iEP", GlobalConfig::thread_q_depth, pool_min, pool_shared);
+    ep.set_drain(make_drain_model("iEP", system_clk.period().to_seconds() * 1e9));
     ep.clk(system_clk);  // Connect EP to common clock
     ep.reset_n(reset_n);
     ep.raw_valid(raw_valid);
     ep.raw_tlp(raw_tlp);
     ep.credit_out(credit);
+    ep.rev_valid(rev_valid);
+    ep.rev_tlp(rev_tlp);
+    ep.rev_ready(rev_ready);
 
     // Signals for TX/RX simple path
     sc_signal<bool>    RC2TX_raw_valid;
@@ -45,54 +674,114 @@ int sc_main(int argc, char* argv[]) {
     sc_signal<bool>    NOC2RX_valid;
     sc_signal<AxiWord> NOC2RX_axi;
     sc_signal<bool>    RX2NOC_ready;
+    sc_signal<sc_uint<3>> NOC2TX_ready_vc;   // per-lane ready (DATA_NOC_VC_MODE)
+    sc_signal<sc_uint<3>> RX2NOC_ready_vc;
     sc_signal<bool>    RX2EP_valid;
     sc_signal<RawTLP>  RX2EP_tlp;
-    sc_signal<sc_uint<3>> iEPcredit_bus;
+    sc_signal<CreditBus>  iEPcredit_bus;
+    sc_signal<CreditBus>  RXcredit_bus;       // RX lane credits (RX_EARLY_CREDIT)
     sc_signal<bool>       Credit_packer2CNOC_valid, CNOC2Credit_packer_ready;
     sc_signal<AxiWord>    Credit_packer2CNOC_AXI_data;
     sc_signal<bool>       CNOC2Credit_Pulser_valid, CreditPulser2CNOC_ready;
     sc_signal<AxiWord>    CNOC2Credit_Pulser_axi_data;
-    sc_signal<sc_uint<3>> iRCcredit_bus;
+    sc_signal<CreditBus>  iRCcredit_bus;
+    sc_signal<bool>       EP2Rev_valid, Rev2EP_ready, Rev2RC_valid;   // reverse data
+    sc_signal<RawTLP>     EP2Rev_tlp, Rev2RC_tlp;
+    sc_signal<bool>       NoRev_valid, NoRev_ready, NoRev2RC_valid;  // idle CNOC ends (dedicated)
+    sc_signal<RawTLP>     NoRev_tlp, NoRev2RC_tlp;
 
     // Create and connect TX path with single FIFO
-    iRC rc_tx("iRC_tx");
+    iRC rc_tx("iRC_tx", GlobalConfig::rc_tx_arbiter, GlobalConfig::rc_tx_weights);
+    rc_tx.set_traffic(make_load_model("iRC_tx", system_clk.period().to_seconds() * 1e9));
     rc_tx.clk(system_clk);
     rc_tx.reset_n(reset_n);
     rc_tx.raw_valid(RC2TX_raw_valid);
     rc_tx.raw_tlp(RC2TX_raw_tlp);
+    rc_tx.init_window = ep_init_window;
 
-    SimpleTxFIFO tx_fifo("TX", TX_FIFO_DEPTH);
-    tx_fifo.clk(system_clk);
-    tx_fifo.reset_n(reset_n);
-    tx_fifo.ingress_valid(RC2TX_raw_valid);
-    tx_fifo.ingress_tlp(RC2TX_raw_tlp);
-    tx_fifo.egress_valid(TX2NOC_valid);
-    tx_fifo.egress_axi(TX2NOC_axi);
-    tx_fifo.egress_ready(NOC2TX_ready);
-
-    // RX simple FIFO
-    SimpleRxFIFO rx_fifo("RX", RX_FIFO_DEPTH);
-    rx_fifo.clk(system_clk);
-    rx_fifo.reset_n(reset_n);
-    rx_fifo.valid_in(NOC2RX_valid);
-    rx_fifo.axi_in(NOC2RX_axi);
-    rx_fifo.ready_out(RX2NOC_ready);
-    rx_fifo.valid_out(RX2EP_valid);
-    rx_fifo.tlp_out(RX2EP_tlp);
+    // TX/RX are either single shared FIFOs or per-thread virtual channels
+    SimpleTxFIFO* tx_fifo = nullptr;
+    SimpleRxFIFO* rx_fifo = nullptr;
+    CreditedRxFIFO* cr_rx_fifo = nullptr;
+    VcTxFIFO*     vc_tx_fifo = nullptr;
+    VcRxFIFO*     vc_rx_fifo = nullptr;
+    if (!DATA_NOC_VC_MODE) {
+        tx_fifo = new SimpleTxFIFO("TX", GlobalConfig::tx_depth, TX_VOQ_ENABLE, TX_VOQ_ARBITER,
+                                   {TX_VOQ_WEIGHTS[0], TX_VOQ_WEIGHTS[1], TX_VOQ_WEIGHTS[2]});
+        tx_fifo->clk(system_clk);
+        tx_fifo->reset_n(reset_n);
+        tx_fifo->ingress_valid(RC2TX_raw_valid);
+        tx_fifo->ingress_tlp(RC2TX_raw_tlp);
+        tx_fifo->egress_valid(TX2NOC_valid);
+        tx_fifo->egress_axi(TX2NOC_axi);
+        tx_fifo->egress_ready(NOC2TX_ready);
+
+        if (!RX_EARLY_CREDIT) {
+            // RX simple FIFO
+            rx_fifo = new SimpleRxFIFO("RX", GlobalConfig::rx_depth);
+            rx_fifo->clk(system_clk);
+            rx_fifo->reset_n(reset_n);
+            rx_fifo->valid_in(NOC2RX_valid);
+            rx_fifo->axi_in(NOC2RX_axi);
+            rx_fifo->ready_out(RX2NOC_ready);
+            rx_fifo->valid_out(RX2EP_valid);
+            rx_fifo->tlp_out(RX2EP_tlp);
+        } else {
+            // RX owns the credit domain toward iRC_tx; iEP credits stay local
+            cr_rx_fifo = new CreditedRxFIFO("RX", RX_EARLY_PER_THREAD);
+            cr_rx_fifo->clk(system_clk);
+            cr_rx_fifo->reset_n(reset_n);
+            cr_rx_fifo->valid_in(NOC2RX_valid);
+            cr_rx_fifo->axi_in(NOC2RX_axi);
+            cr_rx_fifo->ready_out(RX2NOC_ready);
+            cr_rx_fifo->valid_out(RX2EP_valid);
+            cr_rx_fifo->tlp_out(RX2EP_tlp);
+            cr_rx_fifo->ep_credit_in(iEPcredit_bus);
+            cr_rx_fifo->credit_out(RXcredit_bus);
+            rc_tx.init_window = RX_EARLY_PER_THREAD;
+        }
+    } else {
+        vc_tx_fifo = new VcTxFIFO("TX", (GlobalConfig::tx_depth + 2) / 3);
+        vc_tx_fifo->clk(system_clk);
+        vc_tx_fifo->reset_n(reset_n);
+        vc_tx_fifo->ingress_valid(RC2TX_raw_valid);
+        vc_tx_fifo->ingress_tlp(RC2TX_raw_tlp);
+        vc_tx_fifo->egress_valid(TX2NOC_valid);
+        vc_tx_fifo->egress_axi(TX2NOC_axi);
+        vc_tx_fifo->egress_ready(NOC2TX_ready_vc);
+
+        vc_rx_fifo = new VcRxFIFO("RX", GlobalConfig::rx_depth);
+        vc_rx_fifo->clk(system_clk);
+        vc_rx_fifo->reset_n(reset_n);
+        vc_rx_fifo->valid_in(NOC2RX_valid);
+        vc_rx_fifo->axi_in(NOC2RX_axi);
+        vc_rx_fifo->ready_out(RX2NOC_ready_vc);
+        vc_rx_fifo->valid_out(RX2EP_valid);
+        vc_rx_fifo->tlp_out(RX2EP_tlp);
+    }
 
     // iEP instance after RX (consumes TX path)
-    iEP ep_rx("iEP_after_RX", THREAD_Q_DEPTH);
+    iEP ep_rx("iEP_after_RX", GlobalConfig::thread_q_depth, pool_min, pool_shared);
+    ep_rx.set_drain(make_drain_model("iEP_after_RX", system_clk.period().to_seconds() * 1e9));
     ep_rx.clk(system_clk);
     ep_rx.reset_n(reset_n);
     ep_rx.raw_valid(RX2EP_valid);
     ep_rx.raw_tlp(RX2EP_tlp);
     ep_rx.credit_out(iEPcredit_bus);
+    ep_rx.rev_valid(EP2Rev_valid);
+    ep_rx.rev_tlp(EP2Rev_tlp);
+    ep_rx.rev_ready(Rev2EP_ready);
+    ep_rx.rev_pct = GlobalConfig::reverse_load_pct;
 
     // Credit path over its own deterministic AXI NoC
-    CreditTx Credit_packer("Credit_packer", CREDIT_SENSE_WINDOW);
+    const bool rev_dedicated = GlobalConfig::reverse_load_pct > 0 && GlobalConfig::reverse_dedicated;
+    CreditTx Credit_packer("Credit_packer", GlobalConfig::credit_window, GlobalConfig::credit_tx_adaptive);
     Credit_packer.clk(system_clk);
     Credit_packer.reset_n(reset_n);
-    Credit_packer.credit_in(iEPcredit_bus);
+    Credit_packer.credit_in(cr_rx_fifo ? RXcredit_bus : iEPcredit_bus);
+    Credit_packer.rev_valid_in(rev_dedicated ? NoRev_valid : EP2Rev_valid);
+    Credit_packer.rev_tlp_in(rev_dedicated ? NoRev_tlp : EP2Rev_tlp);
+    Credit_packer.rev_ready_out(rev_dedicated ? NoRev_ready : Rev2EP_ready);
     Credit_packer.valid_out(Credit_packer2CNOC_valid);
     Credit_packer.axi_out(Credit_packer2CNOC_AXI_data);
     Credit_packer.ready_in(CNOC2Credit_packer_ready);
@@ -108,27 +797,131 @@ int sc_main(int argc, char* argv[]) {
     c_noc.axi_out(CNOC2Credit_Pulser_axi_data);
     c_noc.ready_in(CreditPulser2CNOC_ready);
 
-    CreditRx Credit_Pulser("Credit_Pulser");
+    CreditRx Credit_Pulser("Credit_Pulser", GlobalConfig::credit_count_bus,
+                           GlobalConfig::credit_rx_merge);
     Credit_Pulser.clk(system_clk);
     Credit_Pulser.reset_n(reset_n);
     Credit_Pulser.valid_in(CNOC2Credit_Pulser_valid);
     Credit_Pulser.axi_in(CNOC2Credit_Pulser_axi_data);
     Credit_Pulser.ready_out(CreditPulser2CNOC_ready);
     Credit_Pulser.credit_out(iRCcredit_bus);
+    Credit_Pulser.rev_valid_out(rev_dedicated ? NoRev2RC_valid : Rev2RC_valid);
+    Credit_Pulser.rev_tlp_out(rev_dedicated ? NoRev2RC_tlp : Rev2RC_tlp);
+
+    // --reverse-cnoc=dedicated: the reverse data takes its own link instead,
+    // through a second packer/pulser pair that never holds credits
+    CreditTx* rev_packer = nullptr;
+    AxiNoC*   r_noc = nullptr;
+    CreditRx* rev_pulser = nullptr;
+    if (rev_dedicated) {
+        sc_signal<CreditBus>* no_credit = new sc_signal<CreditBus>;
+        sc_signal<CreditBus>* rev_credit = new sc_signal<CreditBus>;
+        sc_signal<bool>*    p2n_valid = new sc_signal<bool>;
+        sc_signal<AxiWord>* p2n_axi   = new sc_signal<AxiWord>;
+        sc_signal<bool>*    n2p_ready = new sc_signal<bool>;
+        sc_signal<bool>*    n2r_valid = new sc_signal<bool>;
+        sc_signal<AxiWord>* n2r_axi   = new sc_signal<AxiWord>;
+        sc_signal<bool>*    r2n_ready = new sc_signal<bool>;
+
+        rev_packer = new CreditTx("Rev_packer", GlobalConfig::credit_window, true);
+        rev_packer->clk(system_clk);
+        rev_packer->reset_n(reset_n);
+        rev_packer->credit_in(*no_credit);
+        rev_packer->rev_valid_in(EP2Rev_valid);
+        rev_packer->rev_tlp_in(EP2Rev_tlp);
+        rev_packer->rev_ready_out(Rev2EP_ready);
+        rev_packer->valid_out(*p2n_valid);
+        rev_packer->axi_out(*p2n_axi);
+        rev_packer->ready_in(*n2p_ready);
+
+        r_noc = new AxiNoC("RNOC", CREDIT_NOC_LATENCY, NOC_PATTERN_LEN, CREDIT_NOC_STALL_PCT);
+        r_noc->clk(system_clk);
+        r_noc->reset_n(reset_n);
+        r_noc->valid_in(*p2n_valid);
+        r_noc->axi_in(*p2n_axi);
+        r_noc->ready_out(*n2p_ready);
+        r_noc->valid_out(*n2r_valid);
+        r_noc->axi_out(*n2r_axi);
+        r_noc->ready_in(*r2n_ready);
+
+        rev_pulser = new CreditRx("Rev_pulser", true);
+        rev_pulser->clk(system_clk);
+        rev_pulser->reset_n(reset_n);
+        rev_pulser->valid_in(*n2r_valid);
+        rev_pulser->axi_in(*n2r_axi);
+        rev_pulser->ready_out(*r2n_ready);
+        rev_pulser->credit_out(*rev_credit);
+        rev_pulser->rev_valid_out(Rev2RC_valid);
+        rev_pulser->rev_tlp_out(Rev2RC_tlp);
+    }
 
     // Connect to iRC_tx
     rc_tx.credit_in(iRCcredit_bus);
+    rc_tx.rev_valid(Rev2RC_valid);
+    rc_tx.rev_tlp(Rev2RC_tlp);
+    LatencyProbe rev_probe;   // reverse data, iEP_after_RX -> iRC_tx
+    ep_rx.rev_probe = rc_tx.rev_probe = &rev_probe;
 
     // ------------------- Data path NoC (TX → RX) ---------------------------
-    AxiNoC noc("AXI_NOC", DATA_NOC_LATENCY, NOC_PATTERN_LEN, DATA_NOC_STALL_PCT);
-    noc.clk(system_clk);
-    noc.reset_n(reset_n);
-    noc.valid_in(TX2NOC_valid);
-    noc.axi_in(TX2NOC_axi);
-    noc.ready_out(NOC2TX_ready);
-    noc.valid_out(NOC2RX_valid);
-    noc.axi_out(NOC2RX_axi);
-    noc.ready_in(RX2NOC_ready);
+    AxiNoC*   noc = nullptr;
+    VcAxiNoC* vc_noc = nullptr;
+    CreditedAxiNoC* cr_noc = nullptr;
+    if (DATA_NOC_CREDITED) {
+        cr_noc = new CreditedAxiNoC("AXI_NOC", DATA_NOC_LATENCY, CREDITED_NOC_HOPS, CREDITED_NOC_HOP_BUF,
+                                    CREDITED_NOC_CREDIT_LAT, NOC_PATTERN_LEN, DATA_NOC_STALL_PCT);
+        cr_noc->clk(system_clk);
+        cr_noc->reset_n(reset_n);
+        cr_noc->valid_in(TX2NOC_valid);
+        cr_noc->axi_in(TX2NOC_axi);
+        cr_noc->ready_out(NOC2TX_ready);
+        cr_noc->valid_out(NOC2RX_valid);
+        cr_noc->axi_out(NOC2RX_axi);
+        cr_noc->ready_in(RX2NOC_ready);
+    } else if (!DATA_NOC_VC_MODE) {
+        noc = new AxiNoC("AXI_NOC", DATA_NOC_LATENCY, NOC_PATTERN_LEN, DATA_NOC_STALL_PCT);
+        noc->clk(system_clk);
+        noc->reset_n(reset_n);
+        noc->valid_in(TX2NOC_valid);
+        noc->axi_in(TX2NOC_axi);
+        noc->ready_out(NOC2TX_ready);
+        noc->valid_out(NOC2RX_valid);
+        noc->axi_out(NOC2RX_axi);
+        noc->ready_in(RX2NOC_ready);
+    } else {
+        vc_noc = new VcAxiNoC("AXI_NOC", DATA_NOC_LATENCY, GlobalConfig::thread_q_depth, NOC_PATTERN_LEN, DATA_NOC_STALL_PCT);
+        vc_noc->clk(system_clk);
+        vc_noc->reset_n(reset_n);
+        vc_noc->valid_in(TX2NOC_valid);
+        vc_noc->axi_in(TX2NOC_axi);
+        vc_noc->ready_out(NOC2TX_ready_vc);
+        vc_noc->valid_out(NOC2RX_valid);
+        vc_noc->axi_out(NOC2RX_axi);
+        vc_noc->ready_in(RX2NOC_ready_vc);
+    }
+
+    // ------------------- Optional mesh fabric -------------------------------
+    MeshNoC* mesh = nullptr;
+    MeshNoC* c_mesh = nullptr;
+    std::vector<MeshPair*> mesh_pairs;
+    if (MESH_ENABLE) {
+        mesh = new MeshNoC("MESH", MESH_DIM_X, MESH_DIM_Y, MESH_TORUS, MESH_LINK_LATENCY,
+                           NOC_PATTERN_LEN, MESH_LINK_STALL_PCT, MESH_ROUTER_BUF_DEPTH);
+        c_mesh = new MeshNoC("CMESH", MESH_DIM_X, MESH_DIM_Y, MESH_TORUS, MESH_LINK_LATENCY,
+                             NOC_PATTERN_LEN, MESH_LINK_STALL_PCT, MESH_ROUTER_BUF_DEPTH);
+        for (MeshNoC* m : {mesh, c_mesh}) {
+            m->clk(system_clk);
+            m->reset_n(reset_n);
+        }
+        MeshSignals* data_sig = new MeshSignals(*mesh);
+        MeshSignals* credit_sig = new MeshSignals(*c_mesh);
+        const unsigned nodes = mesh->num_nodes();
+        for (unsigned k = 0; k < MESH_PAIRS; ++k) {
+            const unsigned src = k, dst = nodes - 1 - k;
+            mesh->set_route(src, dst);
+            c_mesh->set_route(dst, src);
+            mesh_pairs.push_back(new MeshPair(k, src, dst, system_clk, reset_n, *data_sig, *credit_sig));
+        }
+    }
 
     // Create trace files
     sc_trace_file* tf = sc_create_vcd_trace_file("irc_iep");
@@ -149,11 +942,17 @@ int sc_main(int argc, char* argv[]) {
     sc_trace(tf_tx, RC2TX_raw_valid, "RC2TX_raw_valid");
     sc_trace(tf_tx, RC2TX_raw_tlp,  "RC2TX_raw_tlp");
     sc_trace(tf_tx, TX2NOC_valid,    "TX2NOC_valid");
-    sc_trace(tf_tx, NOC2TX_ready, "NOC2TX_ready");
+    if (!DATA_NOC_VC_MODE)
+        sc_trace(tf_tx, NOC2TX_ready, "NOC2TX_ready");
+    else
+        sc_trace(tf_tx, NOC2TX_ready_vc, "NOC2TX_ready_vc");
     sc_trace(tf_tx, TX2NOC_axi,   "TX2NOC_axi");
     sc_trace(tf_tx, NOC2RX_valid,  "NOC2RX_valid");
     sc_trace(tf_tx, NOC2RX_axi,    "NOC2RX_axi");
-    sc_trace(tf_tx, RX2NOC_ready,  "RX2NOC_ready");
+    if (!DATA_NOC_VC_MODE)
+        sc_trace(tf_tx, RX2NOC_ready,  "RX2NOC_ready");
+    else
+        sc_trace(tf_tx, RX2NOC_ready_vc, "RX2NOC_ready_vc");
     sc_trace(tf_tx, RX2EP_valid, "RX2EP_valid");
     sc_trace(tf_tx, RX2EP_tlp,   "RX2EP_tlp");
     // Credit path traces
@@ -165,10 +964,14 @@ int sc_main(int argc, char* argv[]) {
     sc_trace(tf_tx, CNOC2Credit_Pulser_axi_data,   "CNOC2Credit_Pulser_axi_data");
     sc_trace(tf_tx, iRCcredit_bus, "iRCcredit_bus");
     sc_trace(tf_tx, iEPcredit_bus, "iEPcredit_bus");
-    sc_trace(tf_tx, c_noc.stall_active_sig, "CNOC_stall_active");
-    sc_trace(tf_tx, c_noc.delta_cycle_ctr, "CNOC_delta_cycle_ctr");
-    sc_trace(tf_tx, noc.stall_active_sig, "DATA_NOC_stall_active");
-    sc_trace(tf_tx, noc.delta_cycle_ctr, "DATA_NOC_delta_cycle_ctr");
+    sc_trace(tf_tx, c_noc.link.stall_active_sig, "CNOC_stall_active");
+    sc_trace(tf_tx, c_noc.link.delta_cycle_ctr, "CNOC_delta_cycle_ctr");
+    if (!DATA_NOC_VC_MODE) {
+        sc_trace(tf_tx, noc->link.stall_active_sig, "DATA_NOC_stall_active");
+        sc_trace(tf_tx, noc->link.delta_cycle_ctr, "DATA_NOC_delta_cycle_ctr");
+    } else {
+        sc_trace(tf_tx, vc_noc->lane_stall, "DATA_NOC_lane_stall");
+    }
 
     // Duty cycle monitor instance
     CreditDutyMon mon("CreditMon");
@@ -182,34 +985,358 @@ int sc_main(int argc, char* argv[]) {
     ep.setup_tracing(true);                    // iEP_trace.vcd
     rc_tx.setup_tracing(true);                 // iRC_tx_trace.vcd
     ep_rx.setup_tracing(true);                 // iEP_after_RX_trace.vcd
-    tx_fifo.setup_tracing(true);               // TX_trace.vcd
-    rx_fifo.setup_tracing(true);               // RX_trace.vcd
+    if (!DATA_NOC_VC_MODE) {
+        tx_fifo->setup_tracing(true);          // TX_trace.vcd
+        if (rx_fifo)
+            rx_fifo->setup_tracing(true);      // RX_trace.vcd
+        else
+            cr_rx_fifo->setup_tracing(true);   // RX_trace.vcd
+        if (noc)
+            noc->setup_tracing(true);          // AXI_NOC_trace.vcd
+        else
+            cr_noc->setup_tracing(true);       // AXI_NOC_trace.vcd
+    } else {
+        vc_tx_fifo->setup_tracing(true);       // TX_trace.vcd
+        vc_rx_fifo->setup_tracing(true);       // RX_trace.vcd
+        vc_noc->setup_tracing(true);           // AXI_NOC_trace.vcd
+    }
     Credit_packer.setup_tracing(true);         // Credit_packer_trace.vcd
     Credit_Pulser.setup_tracing(true);         // Credit_Pulser_trace.vcd
     c_noc.setup_tracing(true);                 // CNOC_trace.vcd
-    noc.setup_tracing(true);                   // AXI_NOC_trace.vcd
     mon.setup_tracing(true);                   // CreditMon_trace.vcd
+    if (MESH_ENABLE) {
+        mesh->setup_tracing(true);             // MESH_trace.vcd
+        c_mesh->setup_tracing(true);           // CMESH_trace.vcd
+    }
+
+    // Structural parameters a checkpoint is only valid for
+    const std::string shape = "tx_depth=" + std::to_string(GlobalConfig::tx_depth)
+        + " rx_depth=" + std::to_string(GlobalConfig::rx_depth)
+        + " thread_q_depth=" + std::to_string(GlobalConfig::thread_q_depth)
+        + " data_noc_latency=" + std::to_string(DATA_NOC_LATENCY)
+        + " credit_noc_latency=" + std::to_string(CREDIT_NOC_LATENCY)
+        + " tx_voq=" + std::to_string(TX_VOQ_ENABLE)
+        + " ep_pool=" + std::to_string(pool_min) + "," + std::to_string(pool_shared);
+
+    LatencyProbe probe[2];   // in-simulator latency per path, see below
+
+    if (!restoring) {
+        // Initial values
+        reset_n.write(false);
+
+        // Apply reset for 20ns
+        sc_start(20, SC_NS);
+        reset_n.write(true);
+    } else {
+        // Out of reset from the start; no edge comes before resume_at, so
+        // the modules only initialise and are then overwritten
+        if (restored.shape != shape)
+            SC_REPORT_FATAL("checkpoint", ("saved with " + restored.shape + ", this run has " + shape).c_str());
+        reset_n.write(true);
+        sc_start(resume_at);
+        rc.load_state(restored);
+        rc_tx.load_state(restored);
+        ep.load_state(restored);
+        ep_rx.load_state(restored);
+        tx_fifo->load_state(restored);
+        rx_fifo->load_state(restored);
+        noc->load_state(restored);
+        c_noc.load_state(restored);
+        Credit_packer.load_state(restored);
+        Credit_Pulser.load_state(restored);
+        mon.load_state(restored);
+        probe[0].load(restored, "probe_direct");
+        probe[1].load(restored, "probe_hybrid");
+        rev_probe.load(restored, "probe_reverse");
+        std::cout << "*** Restored " << GlobalConfig::restore_file << " at " << sc_time_stamp()
+                  << " ***" << std::endl;
+    }
+
+    auto save_checkpoint = [&](const std::string& file) {
+        std::ofstream os(file);
+        os << std::setprecision(17) << "checkpoint 1 " << sc_time_stamp().value() << "\n" << shape << "\n";
+        rc.save_state(os);
+        rc_tx.save_state(os);
+        ep.save_state(os);
+        ep_rx.save_state(os);
+        tx_fifo->save_state(os);
+        rx_fifo->save_state(os);
+        noc->save_state(os);
+        c_noc.save_state(os);
+        Credit_packer.save_state(os);
+        Credit_Pulser.save_state(os);
+        mon.save_state(os);
+        probe[0].save(os, "probe_direct");
+        probe[1].save(os, "probe_hybrid");
+        rev_probe.save(os, "probe_reverse");
+        if (!os)
+            SC_REPORT_FATAL("checkpoint", ("cannot write '" + file + "'").c_str());
+        std::cout << "*** Checkpoint " << file << " at " << sc_time_stamp() << " ***" << std::endl;
+    };
 
-    // Initial values
-    reset_n.write(false);
-    
-    // Apply reset for 20ns
-    sc_start(20, SC_NS);
-    reset_n.write(true);
-    
-    // Phase-1 : run for first half of sim_time_in_us with normal operation
-    const unsigned phase1_us = sim_time_in_us / 2;
-    sc_start(static_cast<double>(phase1_us), SC_US);
+    // Scenario phases; the default runs with popping for half of
+    // sim_time_in_us (--steady: until converged) and then drains until the
+    // paths are quiet
+    std::vector<ScenarioPhase> phases;
+    std::string err;
+    const std::string default_phases = "run " + (GlobalConfig::steady ? std::string("steady")
+                                                                       : std::to_string(sim_time_in_us / 2))
+                                     + "; drain drained pop=off traffic=off";
+    const bool parsed = GlobalConfig::scenario_file.empty()
+        ? parse_scenario(GlobalConfig::phases.empty() ? default_phases : GlobalConfig::phases, phases, err)
+        : load_scenario(GlobalConfig::scenario_file, phases, err);
+    if (!parsed)
+        SC_REPORT_FATAL("scenario", err.c_str());
 
-    // Disable queue popping in iEP so that no new credits are generated
-    GlobalConfig::enable_popping = false;
-    std::cout << "*** Disabled iEP popping at " << sc_time_stamp() << " ***" << std::endl;
+    const double cycle_ns = system_clk.period().to_seconds() * 1e9;
+    auto apply = [&](const std::string& key, const std::string& val) {
+        const unsigned pct = static_cast<unsigned>(std::max(0, std::atoi(val.c_str())));
+        if (key == "load") {
+            GlobalConfig::traffic_load_pct = pct;
+            if (GlobalConfig::traffic == "sat" || GlobalConfig::traffic == "trace") {
+                std::cout << "*** load= ignored: no open-loop traffic model ***" << std::endl;
+                return;
+            }
+            rc.set_traffic(make_load_model("iRC", cycle_ns));
+            rc_tx.set_traffic(make_load_model("iRC_tx", cycle_ns));
+        } else if (key == "traffic") {
+            rc.traffic_on = rc_tx.traffic_on = val == "on";
+            for (MeshPair* p : mesh_pairs)
+                p->rc->traffic_on = val == "on";
+        } else if (key == "pop") {
+            GlobalConfig::enable_popping = val == "on";
+            if (!GlobalConfig::enable_popping)
+                std::cout << "*** Disabled iEP popping at " << sc_time_stamp() << " ***" << std::endl;
+        } else if (key == "drain" || key == "drain-rate") {
+            if (key == "drain")
+                GlobalConfig::drain = val;
+            else
+                GlobalConfig::drain_rate_pct = pct;
+            ep.set_drain(make_drain_model("iEP", cycle_ns));
+            ep_rx.set_drain(make_drain_model("iEP_after_RX", cycle_ns));
+        } else if (key == "stall") {
+            const unsigned stall = std::min(99u, pct);
+            if (noc)
+                noc->link.NOC_STALL_PCT = stall;
+            else if (cr_noc)
+                cr_noc->NOC_STALL_PCT = stall;
+            else
+                vc_noc->NOC_STALL_PCT = stall;
+        } else if (key == "credit-stall") {
+            c_noc.link.NOC_STALL_PCT = std::min(99u, pct);
+            if (r_noc)
+                r_noc->link.NOC_STALL_PCT = c_noc.link.NOC_STALL_PCT;
+        } else if (key == "window") {
+            Credit_packer.window_size = std::max(1u, pct);
+        } else if (key == "seed") {
+            GlobalConfig::seed = static_cast<unsigned>(std::strtoul(val.c_str(), nullptr, 10));
+            rc.set_traffic(make_load_model("iRC", cycle_ns));
+            rc_tx.set_traffic(make_load_model("iRC_tx", cycle_ns));
+            ep.set_drain(make_drain_model("iEP", cycle_ns));
+            ep_rx.set_drain(make_drain_model("iEP_after_RX", cycle_ns));
+        }
+    };
 
-    // Phase-2 : let pipeline drain for the remaining time
-    sc_start(static_cast<double>(sim_time_in_us - phase1_us), SC_US);
+    // Re-runs (see scenario.h); without --reruns a single run as configured
+    std::vector<ScenarioRerun> runs;
+    if (!GlobalConfig::reruns.empty() || !GlobalConfig::rerun_file.empty()) {
+        const bool ok = GlobalConfig::rerun_file.empty() ? parse_reruns(GlobalConfig::reruns, runs, err)
+                                                         : load_reruns(GlobalConfig::rerun_file, runs, err);
+        if (!ok)
+            SC_REPORT_FATAL("reruns", err.c_str());
+    } else {
+        runs.emplace_back();
+    }
+
+    // In-simulator latency per path, needed by "steady" phases and the
+    // re-run table
+    if (runs.size() > 1 || !runs[0].settings.empty() ||
+        std::any_of(phases.begin(), phases.end(), [](const ScenarioPhase& ph) { return ph.until_steady; })) {
+        rc.probe = ep.probe = &probe[0];
+        rc_tx.probe = ep_rx.probe = &probe[1];
+    }
+
+    // Every run starts from the command-line configuration with fresh models,
+    // as a new process would
+    const unsigned base_load = GlobalConfig::traffic_load_pct;
+    const std::string base_drain = GlobalConfig::drain;
+    const unsigned base_drain_rate = GlobalConfig::drain_rate_pct;
+    const unsigned base_seed = GlobalConfig::seed;
+    auto soft_reset = [&]() {
+        reset_n.write(false);
+        GlobalConfig::traffic_load_pct = base_load;
+        GlobalConfig::drain = base_drain;
+        GlobalConfig::drain_rate_pct = base_drain_rate;
+        GlobalConfig::seed = base_seed;
+        apply("pop", "on");
+        apply("traffic", "on");
+        apply("stall", std::to_string(DATA_NOC_STALL_PCT));
+        apply("credit-stall", std::to_string(CREDIT_NOC_STALL_PCT));
+        apply("window", std::to_string(GlobalConfig::credit_window));
+        rc.set_arbiter(make_arbiter(GlobalConfig::rc_arbiter, 3, GlobalConfig::rc_weights));
+        rc_tx.set_arbiter(make_arbiter(GlobalConfig::rc_tx_arbiter, 3, GlobalConfig::rc_tx_weights));
+        rc.set_traffic(make_load_model("iRC", cycle_ns));
+        rc_tx.set_traffic(make_load_model("iRC_tx", cycle_ns));
+        ep.set_drain(make_drain_model("iEP", cycle_ns));
+        ep_rx.set_drain(make_drain_model("iEP_after_RX", cycle_ns));
+        if (TX_VOQ_ENABLE)
+            tx_fifo->set_arbiter(make_arbiter(TX_VOQ_ARBITER, 3,
+                                              {TX_VOQ_WEIGHTS[0], TX_VOQ_WEIGHTS[1], TX_VOQ_WEIGHTS[2]}));
+        for (LatencyProbe& p : probe)
+            p.inflight.clear();   // sequence numbers restart after reset
+        sc_start(RERUN_RESET_CYCLES * cycle_ns, SC_NS);
+        // each run reports from zero, like a fresh process
+        rc.clear_stats();
+        rc_tx.clear_stats();
+        ep.clear_stats();
+        ep_rx.clear_stats();
+        tx_fifo->clear_stats();
+        rx_fifo->clear_stats();
+        Credit_packer.clear_stats();
+        Credit_Pulser.clear_stats();
+        if (rev_packer) {
+            rev_packer->clear_stats();
+            rev_pulser->clear_stats();
+        }
+        mon.clear_stats();
+        for (LatencyProbe& p : probe) {
+            p.samples = 0;
+            p.sum_ns = 0.0;
+        }
+        rev_probe.inflight.clear();
+        rev_probe.samples = 0;
+        rev_probe.sum_ns = 0.0;
+        reset_n.write(true);
+    };
+
+    double popping_us = 0.0;   // time with iEP popping on in the last run, for the mesh report
+    std::vector<RunResult> results;
+    for (size_t k = 0; k < runs.size(); ++k) {
+        if (k > 0)
+            soft_reset();
+        for (const auto& kv : runs[k].settings)
+            apply(kv.first, kv.second);
+        if (runs.size() > 1)
+            std::cout << "*** Run " << k << " (" << (runs[k].label.empty() ? "-" : runs[k].label) << ") at "
+                      << sc_time_stamp() << " ***" << std::endl;
+        const PhaseSample run_start(rc, rc_tx, ep, ep_rx);
+        double run_popping_us = 0.0;
+        for (const ScenarioPhase& ph : phases) {
+            for (const auto& kv : ph.settings)
+                apply(kv.first, kv.second);
+            std::cout << "*** Phase " << ph.name << " at " << sc_time_stamp() << " ***" << std::endl;
+
+            const PhaseSample start(rc, rc_tx, ep, ep_rx);
+            if (ph.until_steady) {
+                run_until_steady(ep, ep_rx, probe);
+            } else if (!ph.until_drained) {
+                sc_start(ph.duration_us, SC_US);
+            } else {
+                // run in quiet-window steps until nothing moved in a whole window
+                uint64_t last = start.activity();
+                double ran = 0.0;
+                bool quiet = false;
+                while (!quiet && ran < SCENARIO_DRAIN_MAX_US) {
+                    sc_start(static_cast<double>(SCENARIO_QUIET_US), SC_US);
+                    ran += SCENARIO_QUIET_US;
+                    const uint64_t now = PhaseSample(rc, rc_tx, ep, ep_rx).activity();
+                    quiet = now == last;
+                    last = now;
+                }
+                std::cout << "*** " << (quiet ? "Drained" : "Drain did not settle") << " after "
+                          << ran << " us ***" << std::endl;
+            }
+            const PhaseSample end(rc, rc_tx, ep, ep_rx);
+            if (GlobalConfig::enable_popping)
+                run_popping_us += end.t_us - start.t_us;
+            report_phase(ph.name, start, end);
+
+            // warm state for later --restore runs
+            if (k == 0 && &ph == &phases.front() && !GlobalConfig::checkpoint_file.empty())
+                save_checkpoint(GlobalConfig::checkpoint_file);
+        }
+        results.push_back({run_start, PhaseSample(rc, rc_tx, ep, ep_rx), run_popping_us});
+        popping_us = run_popping_us;
+    }
+    if (runs.size() > 1 || !runs[0].settings.empty())
+        report_reruns(runs, results);
+    if (runs.size() > 1)
+        std::cout << "\n*** Module reports below cover the last run only ***\n";
 
     // Print duty cycle stats
     mon.report();
+    rc.report();
+    rc_tx.report();
+    Credit_packer.report();
+    Credit_Pulser.report();
+    if (rev_packer) {
+        rev_packer->report();
+        rev_pulser->report();
+    }
+    ep.threaded_queues->report();
+    ep_rx.threaded_queues->report();
+    ep.report();
+    ep_rx.report();
+    if (!DATA_NOC_VC_MODE)
+        tx_fifo->report();
+    else
+        vc_tx_fifo->report();
+    if (cr_rx_fifo)
+        cr_rx_fifo->report();
+    if (cr_noc)
+        cr_noc->report();
+    if (GlobalConfig::reverse_load_pct) {
+        // link beats the reverse traffic and the credits took together; run
+        // both --reverse-cnoc modes to compare
+        const uint64_t cnoc = Credit_packer.beats + Credit_packer.rev_beats;
+        const uint64_t rnoc = rev_packer ? rev_packer->rev_beats : 0;
+        std::cout << "\n---- Reverse traffic (" << (rev_packer ? "dedicated" : "shared") << " CNOC) ----\n";
+        std::cout << "Delivered to iRC_tx : " << rc_tx.rev_received << " of " << ep_rx.rev_offered << "\n";
+        if (rev_probe.samples)
+            std::cout << "Reverse latency     : " << rev_probe.sum_ns / rev_probe.samples << " ns avg\n";
+        std::cout << "Link beats          : " << cnoc + rnoc << " (CNOC " << cnoc << ", RNOC " << rnoc << ")\n";
+        std::cout << "iRC_tx credit RTT   : " << rc_tx.avg_rtt_ns() << " ns avg\n";
+    }
+    if (GlobalConfig::size_depths)
+        report_depth_sizing(rc, rc_tx, tx_fifo, rx_fifo, system_clk.period().to_seconds() * 1e9);
+
+    // Model error against this run, when the run matches what the model
+    // describes: its own settings throughout, on the default topology
+    const bool fixed_settings = std::all_of(phases.begin(), phases.end(), [](const ScenarioPhase& ph) {
+        return std::all_of(ph.settings.begin(), ph.settings.end(),
+                           [](const std::pair<std::string, std::string>& kv) { return kv.first == "pop" || kv.first == "traffic"; });
+    }) && runs.size() == 1 && runs[0].settings.empty();
+    if (fixed_settings && !restoring && !DATA_NOC_VC_MODE && !DATA_NOC_CREDITED && !RX_EARLY_CREDIT &&
+        !EP_SHARED_POOL && GlobalConfig::reverse_load_pct == 0) {
+        const iRC* rcs[2] = {&rc, &rc_tx};
+        const uint64_t popped[2] = {ep.threaded_queues->pkts_popped, ep_rx.threaded_queues->pkts_popped};
+        double sim[2][3];
+        for (int p = 0; p < 2; ++p) {
+            sim[p][0] = popping_us > 0 ? popped[p] / popping_us : -1.0;
+            sim[p][1] = rcs[p]->rtt_samples ? rcs[p]->avg_rtt_ns() : -1.0;
+            sim[p][2] = probe[p].samples ? probe[p].sum_ns / probe[p].samples : -1.0;
+        }
+        report_credit_model(estimate_credit_loop(credit_loop_params(), system_clk.period().to_seconds() * 1e9), sim);
+    }
+
+    if (MESH_ENABLE) {
+        mesh->report();
+        c_mesh->report();
+        std::cout << "\n---- Mesh pairs (throughput over popping phase) ----\n";
+        std::cout << "pair src dst hops  delivered   Mpps  credit_rtt_ns  max_rtt_ns  max_tx_occ\n";
+        for (size_t k = 0; k < mesh_pairs.size(); ++k) {
+            const MeshPair& p = *mesh_pairs[k];
+            std::cout << std::setw(4) << k << std::setw(4) << p.src << std::setw(4) << p.dst
+                      << std::setw(5) << (mesh->hops(p.src, p.dst) + c_mesh->hops(p.dst, p.src)) / 2
+                      << std::setw(11) << p.ep->threaded_queues->pkts_popped
+                      << std::setw(7) << std::fixed << std::setprecision(2)
+                      << (popping_us > 0 ? p.ep->threaded_queues->pkts_popped / popping_us : 0.0)
+                      << std::setw(15) << std::setprecision(1) << p.rc->avg_rtt_ns()
+                      << std::setw(12) << p.rc->rtt_max_ns
+                      << std::setw(12) << p.tx->max_occ << "\n";
+        }
+        std::cout.unsetf(std::ios::fixed);
+    }
 
     // Close trace files
     sc_close_vcd_trace_file(tf);
@@ -1,4 +1,25 @@
 #include "modules.h"
+#include "checkpoint.h"
+#include <algorithm>
+#include <iomanip>
+
+unsigned SharedCreditPool::shared_in_use() const
+{
+    unsigned used = 0;
+    for (unsigned t = 0; t < 3; ++t)
+        if (outstanding[t] > MIN_PER_THREAD)
+            used += outstanding[t] - MIN_PER_THREAD;
+    return used;
+}
+
+bool SharedCreditPool::try_reserve(unsigned lane)
+{
+    // the guaranteed minimum is always free; beyond it borrow a shared slot
+    if (outstanding[lane] >= MIN_PER_THREAD && shared_in_use() >= SHARED)
+        return false;
+    outstanding[lane]++;
+    return true;
+}
 
 void Threaded_Queue::main_thread()
 {
@@ -7,7 +28,7 @@ void Threaded_Queue::main_thread()
     // Initialize
     credits = 0;
     credit_pending = false;
-    credit_out.write(false);
+    credit_out.write(0);
 
     while (true)
     {
@@ -24,20 +45,60 @@ void Threaded_Queue::main_thread()
             } // Clear the FIFO
             credits = 0;
             credit_pending = false;
-            credit_out.write(false);
+            linked = false;
+            sent_at = 0;
+            unspent.clear();
+            credit_out.write(0);
+            if (pool)
+                pool->outstanding[lane] = 0;
             continue;
         }
 
         // Handle credit updates first
         if (credit_pending)
         {
-            credit_out.write(false);
+            credit_out.write(0);
             credit_pending = false;
         }
 
+        // InitFC: advertise the whole queue (in pool mode the guaranteed
+        // share) in one message at link-up instead of one credit per cycle
+        bool advertised = false;
+        if (!linked)
+        {
+            linked = true;
+            if (GlobalConfig::init_fc)
+            {
+                unsigned n = 0;
+                while (credits < (pool ? pool->MIN_PER_THREAD : capacity) && n < CREDIT_CNT_MAX &&
+                       (!pool || pool->try_reserve(lane)))
+                {
+                    credits++;
+                    n++;
+                    if (pool)
+                        unspent.push_back(cycle);
+                }
+                if (n > 0)
+                {
+                    credit_out.write(n);
+                    credit_pending = true;
+                    std::cout << sc_time_stamp() << " [" << name() << "] " << __FUNCTION__
+                              << " InitFC credits=" << n << std::endl;
+                    advertised = true;
+                }
+            }
+        }
+
         // Enqueue packet if valid and space available
+        cycle++;
         if (valid_in.read() && fifo.num_free() > 0)
         {
+            sent_at = cycle;
+            if (pool && !unspent.empty())
+            {
+                pool->saw_loop(cycle - unspent.front());
+                unspent.pop_front();
+            }
             RawTLP pkt = raw_tlp_in.read();
             fifo.write(pkt);
             std::cout << sc_time_stamp() << " [" << name() << "] " << __FUNCTION__
@@ -45,11 +106,23 @@ void Threaded_Queue::main_thread()
                       << " (FIFO occ=" << fifo.num_available() << ")" << std::endl;
         }
 
-        // Issue credit if space available and credits not maxed out
-        if (credits < capacity && fifo.num_free() > 0)
+        // Issue credit if space available and credits not maxed out; in pool
+        // mode the slot must also be reserved in the shared pool.  Beyond the
+        // guaranteed share a thread only borrows while it spends what it has:
+        // it must have sent, and left no credit unspent, within two credit
+        // loops.  So an idle thread takes no shared slots, a light one only
+        // what its rate needs, and one that drains leaves the slots its pops
+        // free to the pool.
+        const uint64_t hold = pool ? 2 * pool->loop : 0;
+        const bool borrow = sent_at > 0 && cycle - sent_at < hold &&
+                            (unspent.empty() || cycle - unspent.front() < hold);
+        if (!advertised && credits < capacity && fifo.num_free() > 0 &&
+            (!pool || ((credits < pool->MIN_PER_THREAD || borrow) && pool->try_reserve(lane))))
         {
             credits++;
-            credit_out.write(true);
+            if (pool)
+                unspent.push_back(cycle);
+            credit_out.write(1);
             credit_pending = true;
             std::cout << sc_time_stamp() << " [" << name() << "] " << __FUNCTION__
                       << " Issuing credit - Current=" << credits << std::endl;
@@ -71,6 +144,8 @@ bool Threaded_Queue::pop_data(RawTLP &pkt)
         if (credits > 0)
         {
             credits--;
+            if (pool)
+                pool->release(lane);
             std::cout << sc_time_stamp() << " [" << name() << "] " << __FUNCTION__
                       << " seq_num=" << pkt.seq_num << " thread_id=" << pkt.thread_id
                       << " - Credits=" << credits << std::endl;
@@ -87,7 +162,10 @@ bool ThreadedFrontEnd::has_data(int idx) const
 
 bool ThreadedFrontEnd::pop_data(int idx, RawTLP &pkt)
 {
-    return queues[idx]->pop_data(pkt);
+    if (!queues[idx]->pop_data(pkt))
+        return false;
+    pkts_popped++;
+    return true;
 }
 
 // Router thread: demux ingress packet by thread_id -> per-queue signals
@@ -122,73 +200,187 @@ void ThreadedFrontEnd::input_router_thread()
                           << " routed seq_num=" << pkt.seq_num
                           << " thread_id=" << pkt.thread_id
                           << " queue_id=" << (tid - 1) << std::endl;
+                pkts_routed++;
             }
         }
     }
 }
 
-// Combiner: OR-reduce per-queue credit pulses into a 3-bit bus
+// Combiner: gather per-queue credit counts onto the credit bus
 void ThreadedFrontEnd::credit_combine_thread()
 {
     while (true)
     {
         wait(clk.posedge_event());
         wait(SC_ZERO_TIME);
-        sc_uint<3> combined = 0;
+        CreditBus combined = 0;
         for (int i = 0; i < 3; ++i)
-            combined[i] = credit_signals[i].read();
+            credit_set(combined, i, credit_signals[i].read());
         credit_out.write(combined);
+
+        // endpoint SRAM usage: packets held and credits still promised
+        unsigned occ = 0, outstanding = 0;
+        for (int i = 0; i < 3; ++i)
+        {
+            occ += queues[i]->fifo.num_available();
+            outstanding += queues[i]->credits;
+        }
+        if (occ > max_occ)
+            max_occ = occ;
+        if (outstanding > max_outstanding)
+            max_outstanding = outstanding;
     }
 }
 
+void ThreadedFrontEnd::report()
+{
+    std::cout << "\n---- " << name() << " buffers ("
+              << (pool ? "shared pool" : "per-thread FIFOs") << ") ----\n";
+    if (pool)
+        std::cout << "Pool               : " << pool->MIN_PER_THREAD << " per thread + "
+                  << pool->SHARED << " shared\n";
+    std::cout << "SRAM entries       : " << sram_entries() << "\n";
+    std::cout << "Peak occupancy     : " << max_occ << "\n";
+    std::cout << "Peak credits out   : " << max_outstanding << "\n";
+    std::cout << "Packets popped     : " << pkts_popped << "\n";
+}
+
+void ThreadedFrontEnd::clear_stats()
+{
+    pkts_routed = pkts_popped = 0;
+    max_occ = max_outstanding = 0;
+}
+
 void SimpleTxFIFO::main_thread()
 {
     wait(SC_ZERO_TIME);
-    bool holding = false;
-    RawTLP held_pkt;
+    std::vector<bool> req(3);
+    std::vector<uint64_t> stamp(3);
     while (true)
     {
         wait(clk.posedge_event());
 
+        if (!reset_n.read())
+        {
+            // drop queued and held packets; statistics are kept
+            RawTLP dummy;
+            while (fifo.nb_read(dummy))
+            {
+            }
+            for (unsigned t = 0; t < 3; ++t)
+            {
+                voq[t].clear();
+                enq_time[t].clear();
+                queued[t] = 0;
+            }
+            holding = false;
+            egress_valid.write(false);
+            continue;
+        }
+
         // enqueue from iRC_tx
-        if (ingress_valid.read() && fifo.num_free() > 0)
+        unsigned cur_occ = VOQ ? voq[0].size() + voq[1].size() + voq[2].size() : fifo.num_available();
+        const bool has_room = VOQ ? cur_occ < DEPTH : fifo.num_free() > 0;
+        if (ingress_valid.read() && !has_room)
+            dropped++;
+        if (ingress_valid.read() && has_room)
         {
-            fifo.write(ingress_tlp.read());
+            RawTLP pkt = ingress_tlp.read();
+            const unsigned t = thread_lane(pkt);
+            if (VOQ)
+                voq[t].push_back(pkt);
+            else
+                fifo.write(pkt);
+            queued[t]++;
+            enq_time[t].push_back(sc_time_stamp());
         }
 
         // track occupancy - only count actual FIFO entries
-        unsigned cur_occ = fifo.num_available();
+        if (VOQ)
+            cur_occ = voq[0].size() + voq[1].size() + voq[2].size();
         if (cur_occ > max_occ)
         {
             max_occ = cur_occ;
             std::cout << sc_time_stamp()
-                      << " [TX_FIFO] depth=" << max_occ << std::endl;
+                      << " [" << name() << "_FIFO] depth=" << max_occ << std::endl;
+        }
+        cycles++;
+        for (unsigned t = 0; t < 3; ++t)
+        {
+            occ_sum[t] += queued[t];
+            if (queued[t] > max_queued[t])
+                max_queued[t] = queued[t];
         }
 
-        // fetch new packet when current TLP fully sent
-        if (!holding && fifo.nb_read(held_pkt))
+        // the beat driven last cycle is transferred if the consumer's ready
+        // (registered) was high in that same cycle
+        if (holding && egress_valid.read() && egress_ready.read())
         {
-            holding = true;
             std::cout << sc_time_stamp() << " [" << name() << "] " << __FUNCTION__
-                      << " Ready to dequeue seq_num=" << held_pkt.seq_num
+                      << " Handshake: sent seq_num=" << held_pkt.seq_num
                       << " thread_id=" << held_pkt.thread_id << std::endl;
+            const unsigned t = thread_lane(held_pkt);
+            const double w = (sc_time_stamp() - held_enq).to_seconds() * 1e9;
+            sent[t]++;
+            wait_sum_ns[t] += w;
+            if (w > wait_max_ns[t])
+                wait_max_ns[t] = w;
+            if (cycles - drive_cycle < hs_min)
+                hs_min = cycles - drive_cycle;
+            holding = false;
+        }
+        else if (holding)
+        {
+            // head is stuck: every other thread with queued packets waits behind it
+            const unsigned head = thread_lane(held_pkt);
+            for (unsigned t = 0; t < 3; ++t)
+                if (t != head && queued[t] > 0)
+                    hol_cycles[t]++;
         }
 
-        // drive outputs
-        if (holding)
+        // fetch new packet when current TLP fully sent
+        if (!holding)
         {
-            AxiWord w = tlp_to_axi(held_pkt);
-            egress_axi.write(w);
-            egress_valid.write(true);
+            if (VOQ)
+            {
+                // like sc_fifo, a packet becomes visible the cycle after its write
+                for (unsigned t = 0; t < 3; ++t)
+                {
+                    req[t] = !voq[t].empty() && enq_time[t].front() < sc_time_stamp();
+                    stamp[t] = req[t] ? enq_time[t].front().value() : 0;
+                }
+                int t = arb->pick(req, stamp);
+                if (t >= 0)
+                {
+                    held_pkt = voq[t].front();
+                    voq[t].pop_front();
+                    holding = true;
+                }
+            }
+            else
+            {
+                holding = fifo.nb_read(held_pkt);
+            }
 
-            if (egress_ready.read())
+            if (holding)
             {
+                const unsigned t = thread_lane(held_pkt);
+                queued[t]--;
+                held_enq = enq_time[t].front();
+                enq_time[t].pop_front();
+                drive_cycle = cycles;
                 std::cout << sc_time_stamp() << " [" << name() << "] " << __FUNCTION__
-                          << " Handshake: sent seq_num=" << held_pkt.seq_num
+                          << " Ready to dequeue seq_num=" << held_pkt.seq_num
                           << " thread_id=" << held_pkt.thread_id << std::endl;
-                holding = false; // consumer accepted in this cycle
             }
         }
+
+        // drive outputs
+        if (holding)
+        {
+            egress_axi.write(tlp_to_axi(held_pkt));
+            egress_valid.write(true);
+        }
         else
         {
             egress_valid.write(false);
@@ -207,13 +399,22 @@ void SimpleRxFIFO::main_thread()
     {
         wait(clk.posedge_event());
 
-        ready_out.write(fifo.num_free() > 0);
+        if (!reset_n.read())
+        {
+            RawTLP dummy;
+            while (fifo.nb_read(dummy))
+            {
+            }
+            valid_out.write(false);
+            ready_out.write(false);
+            continue;
+        }
 
         unsigned int occ = fifo.num_available();
         if (occ > max_occ)
         {
             max_occ = occ;
-            std::cout << sc_time_stamp() << " [RX_FIFO] depth=" << max_occ << std::endl;
+            std::cout << sc_time_stamp() << " [" << name() << "_FIFO] depth=" << max_occ << std::endl;
         }
 
         if (valid_in.read() && ready_out.read())
@@ -226,7 +427,8 @@ void SimpleRxFIFO::main_thread()
         }
 
         RawTLP pkt;
-        if (fifo.nb_read(pkt))
+        bool popped = fifo.nb_read(pkt);
+        if (popped)
         {
             tlp_out.write(pkt);
             valid_out.write(true);
@@ -235,9 +437,109 @@ void SimpleRxFIFO::main_thread()
         {
             valid_out.write(false);
         }
+
+        // Ready for next cycle: the slot freed by this cycle's read only shows
+        // up in num_free() after the update phase, so count it explicitly.
+        ready_out.write(fifo.num_free() + (popped ? 1 : 0) > 0);
+    }
+}
+
+void CreditedRxFIFO::main_thread()
+{
+    wait(SC_ZERO_TIME);
+    while (true)
+    {
+        wait(clk.posedge_event());
+
+        if (!reset_n.read())
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                lanes[i].clear();
+                ep_credits[i] = 0;
+            }
+            rr = 0;
+            linked = false;
+            valid_out.write(false);
+            credit_out.write(0);
+            ready_out.write(true);
+            continue;
+        }
+
+        CreditBus local = ep_credit_in.read();
+        for (int i = 0; i < 3; ++i)
+            ep_credits[i] += credit_count(local, i);
+
+        if (valid_in.read() && ready_out.read())
+        {
+            RawTLP p = axi_to_tlp(axi_in.read());
+            unsigned lane = thread_lane(p);
+            if (lanes[lane].size() >= PER_THREAD)
+                SC_REPORT_ERROR(name(), "packet arrived without an RX credit");
+            lanes[lane].push_back(p);
+            std::cout << sc_time_stamp() << " [" << name() << "] " << __FUNCTION__
+                      << " Enqueue seq_num=" << p.seq_num << " thread_id=" << p.thread_id << std::endl;
+        }
+        if (occupancy() > max_occ)
+            max_occ = occupancy();
+
+        // Forward one packet whose thread has room in iEP; its RX slot is
+        // returned upstream in the same cycle
+        CreditBus up = 0;
+        int pick = -1;
+        for (unsigned k = 0; k < 3; ++k)
+        {
+            unsigned i = (rr + k) % 3;
+            if (!lanes[i].empty() && ep_credits[i] > 0)
+            {
+                pick = static_cast<int>(i);
+                break;
+            }
+        }
+        if (pick >= 0)
+        {
+            rr = (pick + 1) % 3;
+            tlp_out.write(lanes[pick].front());
+            valid_out.write(true);
+            lanes[pick].pop_front();
+            ep_credits[pick]--;
+            forwarded++;
+            credit_set(up, pick, 1);
+        }
+        else
+        {
+            valid_out.write(false);
+            if (occupancy() > 0)
+                ep_blocked++;
+        }
+
+        // Initial advertisement of the RX lanes at link-up
+        if (!linked)
+        {
+            linked = true;
+            for (int i = 0; i < 3; ++i)
+                credit_set(up, i, PER_THREAD);
+        }
+        credit_out.write(up);
+        ready_out.write(true);
     }
 }
 
+void CreditedRxFIFO::report()
+{
+    std::cout << "\n---- " << name() << " early credit release ----\n";
+    std::cout << "RX entries         : " << 3 * PER_THREAD << " (" << PER_THREAD << " per thread)\n";
+    std::cout << "Peak occupancy     : " << max_occ << "\n";
+    std::cout << "Forwarded to iEP   : " << forwarded << "\n";
+    std::cout << "iEP-blocked cycles : " << ep_blocked << "\n";
+}
+
+void CreditedRxFIFO::clear_stats()
+{
+    max_occ = 0;
+    forwarded = ep_blocked = 0;
+}
+
 void CreditTx::main_thread()
 {
     wait(SC_ZERO_TIME);
@@ -251,31 +553,94 @@ void CreditTx::main_thread()
                 accum[i] = 0;
             ctr = 0;
             sending = false;
+            window = CREDIT_TX_MIN_WINDOW;
+            idle = 0;
+            stalled = 0;
+            rev_held = false;
             valid_out.write(false);
+            rev_ready_out.write(false);
             continue;
         }
 
+        // reverse data handed over by the iEP side
+        if (rev_valid_in.read() && rev_ready_out.read())
+        {
+            rev_pkt = rev_tlp_in.read();
+            rev_held = true;
+        }
+
         // Default deassert
         if (!sending)
             valid_out.write(false);
 
         // count incoming credit pulses every cycle
-        sc_uint<3> in = credit_in.read();
+        CreditBus in = credit_in.read();
         for (int i = 0; i < 3; ++i)
-            if (in[i])
-                accum[i]++;
+            accum[i] += credit_count(in, i);
 
         // When not currently sending, check window expiry
         if (!sending)
         {
-            if (++ctr == window_size)
+            idle++;
+            unsigned total = accum[0] + accum[1] + accum[2];
+            bool send = false;
+            if (rev_held)
+            {
+                // reverse data goes first and carries the held credits, up to
+                // CREDIT_CNT_MAX per thread; the rest wait for the next beat
+                unsigned packed[3];
+                for (int i = 0; i < 3; ++i)
+                    packed[i] = std::min<unsigned>(accum[i], CREDIT_CNT_MAX);
+                pending = rev_data_to_axi(rev_pkt, packed[0], packed[1], packed[2]);
+                rev_held = false;
+                rev_beats++;
+                total = packed[0] + packed[1] + packed[2];
+                if (total > 0)
+                {
+                    piggy_beats++;
+                    piggy_credits += total;
+                }
+                ctr = 0;
+                for (int i = 0; i < 3; ++i)
+                    accum[i] -= packed[i];
+                sending = true;
+                stalled = 0;
+                valid_out.write(true);
+                axi_out.write(pending);
+            }
+            else if (!adaptive)
+            {
+                send = ++ctr >= window_size;   // >=: the window may shrink mid-count
+            }
+            else if (total > 0)
             {
+                // ctr is the age of the oldest credit held here
+                ++ctr;
+                bool urgent = false;
+                for (int i = 0; i < 3; ++i)
+                    if (accum[i] >= CREDIT_TX_URGENT)
+                        urgent = true;
+                if (urgent)
+                    urgent_beats++;
+                else if (idle >= CREDIT_TX_IDLE_CYCLES)
+                    idle_beats++;
+                send = urgent || idle >= CREDIT_TX_IDLE_CYCLES || ctr >= window;
+            }
+            if (send)
+            {
+                // fixed mode builds the packet even if all counts are zero
+                beats++;
+                if (total == 0)
+                    empty_beats++;
+                credits_sent += total;
+                hold_sum += ctr;
+                window_sum += adaptive ? window : window_size;
                 ctr = 0;
-                // Build packet even if some counts are zero – optional
                 pending = credits_to_axi(accum[0], accum[1], accum[2]);
                 for (int i = 0; i < 3; ++i)
                     accum[i] = 0;
                 sending = true;
+                stalled = 0;
                 valid_out.write(true);
                 axi_out.write(pending);
             }
@@ -286,15 +651,58 @@ void CreditTx::main_thread()
             {
                 sending = false; // beat accepted
                 valid_out.write(false);
+                idle = 0;
+                stall_sum += stalled;
+                if (adaptive)
+                {
+                    // backpressure means CNOC is busy: pack more per beat
+                    if (stalled > 0)
+                        window = std::min(window * 2, CREDIT_TX_MAX_WINDOW);
+                    else
+                        window = std::max(window / 2, CREDIT_TX_MIN_WINDOW);
+                }
             }
             else
             {
                 // keep driving same word
+                stalled++;
                 valid_out.write(true);
                 axi_out.write(pending);
             }
         }
+        rev_ready_out.write(!rev_held);
+    }
+}
+
+void CreditTx::report()
+{
+    std::cout << "\n---- " << name() << " credit coalescing ("
+              << (adaptive ? "adaptive" : "fixed") << ") ----\n";
+    std::cout << "Beats sent         : " << beats << " (" << empty_beats << " empty)\n";
+    std::cout << "Credits carried    : " << credits_sent << "\n";
+    if (credits_sent)
+        std::cout << "Beats per credit   : " << double(beats) / credits_sent << "\n";
+    if (rev_beats)
+        std::cout << "Piggybacked        : " << piggy_credits << " credits in "
+                  << piggy_beats << " of " << rev_beats << " reverse data beats\n";
+    if (beats)
+    {
+        std::cout << "Avg hold           : " << double(hold_sum) / beats << " cycles\n";
+        std::cout << "Avg stall          : " << double(stall_sum) / beats << " cycles\n";
+        std::cout << "Avg window         : " << double(window_sum) / beats << " cycles\n";
     }
+    if (adaptive)
+        std::cout << "Urgent/idle beats  : " << urgent_beats << " / " << idle_beats << "\n";
+    if (rev_beats)
+        std::cout << "Link beats         : " << beats + rev_beats << "\n";
+}
+
+void CreditTx::clear_stats()
+{
+    beats = empty_beats = credits_sent = 0;
+    hold_sum = stall_sum = 0;
+    urgent_beats = idle_beats = window_sum = 0;
+    rev_beats = piggy_beats = piggy_credits = 0;
 }
 
 void CreditRx::main_thread()
@@ -310,23 +718,69 @@ void CreditRx::main_thread()
                 emit_cnt[i] = 0;
             ready_out.write(true);
             credit_out.write(0);
+            rev_valid_out.write(false);
             continue;
         }
 
         // Default outputs
         credit_out.write(0);
+        rev_valid_out.write(false);
+
+        cycles++;
+        bool take = valid_in.read() && ready_out.read();
+        if (valid_in.read() && !ready_out.read())
+            stall_cycles++;
+        sc_uint<16> cnt[3];
+        if (take)
+        {
+            AxiWord w = axi_in.read();
+            if (axi_is_rev_data(w))
+            {
+                // reverse data beat: on to the RC, keep the piggybacked credits
+                rev_data++;
+                rev_valid_out.write(true);
+                rev_tlp_out.write(axi_to_tlp(w));
+                for (int i = 0; i < 3; ++i)
+                    cnt[i] = axi_piggy_credits(w, i);
+            }
+            else
+            {
+                axi_to_credits(w, cnt[0], cnt[1], cnt[2]);
+                beats++;
+            }
+        }
+
+        if (count_mode)
+        {
+            // hand the whole beat to iRC at once; only counts wider than a
+            // bus field are carried into the next cycle
+            CreditBus bus = 0;
+            for (int i = 0; i < 3; ++i)
+            {
+                if (take)
+                    emit_cnt[i] += cnt[i];
+                unsigned n = std::min<unsigned>(emit_cnt[i], CREDIT_CNT_MAX);
+                emit_cnt[i] -= n;
+                credit_set(bus, i, n);
+                credits_out += n;
+            }
+            credit_out.write(bus);
+            ready_out.write(true);
+            continue;
+        }
 
         // Emit phase FIRST
         bool empty = (emit_cnt[0] == 0 && emit_cnt[1] == 0 && emit_cnt[2] == 0);
         if (!empty)
         {
-            sc_uint<3> pulse = 0;
+            CreditBus pulse = 0;
             for (int i = 0; i < 3; ++i)
             {
                 if (emit_cnt[i] != 0)
                 {
-                    pulse[i] = 1;
+                    credit_set(pulse, i, 1);
                     emit_cnt[i]--;
+                    credits_out++;
                 }
             }
             credit_out.write(pulse);
@@ -335,24 +789,56 @@ void CreditRx::main_thread()
         // Update empty status after emit phase
         empty = (emit_cnt[0] == 0 && emit_cnt[1] == 0 && emit_cnt[2] == 0);
         
-        // Acceptance of new packet - only when truly empty
-        if (valid_in.read() && empty)
+        // Acceptance of new packet - only when ready was advertised last cycle
+        // (the sender sees the same ready value and retires the beat)
+        if (take)
         {
-            sc_uint<16> cnt0, cnt1, cnt2;
-            axi_to_credits(axi_in.read(), cnt0, cnt1, cnt2);
-            emit_cnt[0] = cnt0;
-            emit_cnt[1] = cnt1;
-            emit_cnt[2] = cnt2;
-            ready_out.write(false); // Deassert ready immediately when packet accepted
+            for (int i = 0; i < 3; ++i)
+            {
+                if (merge)
+                    emit_cnt[i] += cnt[i];
+                else
+                    emit_cnt[i] = cnt[i];
+            }
+            unsigned backlog = emit_cnt[0] + emit_cnt[1] + emit_cnt[2];
+            if (backlog > max_backlog)
+                max_backlog = backlog;
+            // Blocking mode deasserts ready until the counters drain
+            ready_out.write(merge);
         }
         else
         {
             // Set ready for next cycle based on current empty status
-            ready_out.write(empty);
+            ready_out.write(merge || empty);
         }
     }
 }
 
+void CreditRx::report()
+{
+    std::cout << "\n---- " << name() << " credit return ("
+              << (count_mode ? "count" : merge ? "merge" : "block") << ") ----\n";
+    std::cout << "Beats accepted     : " << beats << "\n";
+    if (rev_data)
+        std::cout << "Reverse data beats : " << rev_data << " forwarded\n";
+    std::cout << "Credits returned   : " << credits_out << "\n";
+    if (cycles)
+    {
+        std::cout << "Return rate        : " << double(credits_out) / cycles << " credits/cycle\n";
+        std::cout << "CNOC stall cycles  : " << stall_cycles << " ("
+                  << 100.0 * stall_cycles / cycles << " %)\n";
+    }
+    if (!count_mode)
+        std::cout << "Peak backlog       : " << max_backlog << " credits\n";
+}
+
+void CreditRx::clear_stats()
+{
+    cycles = beats = credits_out = stall_cycles = 0;
+    max_backlog = 0;
+    rev_data = 0;
+}
+
 // Thread for monitoring credit pulses
 void iRC::credit_monitor_thread()
 {
@@ -360,6 +846,7 @@ void iRC::credit_monitor_thread()
     for (int i = 0; i < 3; i++)
     {
         credit_counter[i] = 0;
+        initial_left[i] = init_window;
     }
 
     while (true)
@@ -372,21 +859,58 @@ void iRC::credit_monitor_thread()
             for (int i = 0; i < 3; i++)
             {
                 credit_counter[i] = 0;
+                initial_left[i] = init_window;
+                outstanding[i].clear();
+                credit_time[i].clear();
             }
+            in_reset = true;
         }
         else
         {
-            // Sample credit pulse on any bit
-            sc_uint<3> credits = credit_in.read();
+            if (in_reset)
+            {
+                // link-up: restart the startup measurements
+                in_reset = false;
+                link_up = sc_time_stamp();
+                first_send_ns = -1.0;
+                full_window_ns = -1.0;
+            }
+
+            if (rev_valid.read())
+            {
+                rev_received++;
+                if (rev_probe)
+                    rev_probe->popped(rev_tlp.read().seq_num.to_uint64());
+            }
+
+            // Sample the per-thread credit counts
+            CreditBus credits = credit_in.read();
             bool credit_received = false;
 
             for (int i = 0; i < 3; i++)
             {
-                if (credits[i])
+                for (unsigned n = credit_count(credits, i); n > 0; --n)
                 {
-                    // Credit pulse received for thread i+1 (since threads are 1-3)
+                    // Credit received for thread i+1 (since threads are 1-3)
                     credit_counter[i]++;
+                    credit_time[i].push_back(sc_time_stamp());
                     credit_received = true;
+
+                    if (initial_left[i] > 0)
+                    {
+                        initial_left[i]--;
+                    }
+                    else if (!outstanding[i].empty())
+                    {
+                        double rtt = (sc_time_stamp() - outstanding[i].front()).to_seconds() * 1e9;
+                        outstanding[i].pop_front();
+                        rtt_sum_ns += rtt;
+                        rtt_samples++;
+                        if (rtt > rtt_max_ns)
+                            rtt_max_ns = rtt;
+                        if (rtt_min_ns < 0 || rtt < rtt_min_ns)
+                            rtt_min_ns = rtt;
+                    }
                 }
             }
 
@@ -394,6 +918,10 @@ void iRC::credit_monitor_thread()
             {
                 credit_event.notify();
             }
+
+            if (full_window_ns < 0 && initial_left[0] == 0 && initial_left[1] == 0 &&
+                initial_left[2] == 0)
+                full_window_ns = (sc_time_stamp() - link_up).to_seconds() * 1e9;
         }
     }
 }
@@ -405,7 +933,8 @@ void iRC::sender_thread()
     packet_seq = 1;
     raw_valid.write(false);
 
-    static int current_thread = 1; // Persistent round-robin pointer
+    std::vector<bool> req(3);
+    std::vector<uint64_t> stamp(3);
 
     while (true)
     {
@@ -416,42 +945,91 @@ void iRC::sender_thread()
             // Reset state
             packet_seq = 1;
             raw_valid.write(false);
+            for (int i = 0; i < 3; i++)
+                src_q[i].clear();
             continue;
         }
 
         // By default, deassert valid every cycle
         raw_valid.write(false);
 
-        // Try to send a packet if we have credits for any thread
-        for (int i = 0; i < 3; i++)
+        // Open-loop arrivals go into the source queues whatever the credits
+        // (a trace is held back instead of losing records to a full queue)
+        if (gen && traffic_on)
         {
-            int thread_to_try = ((current_thread - 1 + i) % 3) + 1; // Map 0-2 to 1-3
-
-            if (credit_counter[thread_to_try - 1] > 0)
-            { // Adjust index for credit_counter
-                // Create and send a packet for this thread
-                RawTLP pkt;
-                pkt.seq_num = packet_seq;
-                pkt.thread_id = thread_to_try;
-
-                raw_tlp.write(pkt);
-                raw_valid.write(true); // Assert valid for this cycle only
-                std::cout << sc_time_stamp() << " [" << name() << "] " << __FUNCTION__
-                          << " seq_num=" << pkt.seq_num << " thread_id=" << pkt.thread_id << std::endl;
-
-                // Consume one credit for this thread
-                credit_counter[thread_to_try - 1]--; // Adjust index for credit_counter
-
-                // Increment packet sequence
-                packet_seq++;
+            std::vector<unsigned> room(3);
+            for (int i = 0; i < 3; i++)
+                room[i] = src_q[i].size() < TRAFFIC_SRC_Q_DEPTH ? TRAFFIC_SRC_Q_DEPTH - src_q[i].size() : 0;
+            gen->set_room(room);
+            gen->tick();
+            for (int i = 0; i < 3; i++)
+            {
+                const unsigned n = gen->arrivals(i);
+                for (unsigned k = 0; k < n; ++k)
+                {
+                    offered[i]++;
+                    if (gen->holds_back() || src_q[i].size() < TRAFFIC_SRC_Q_DEPTH)
+                        src_q[i].push_back(sc_time_stamp() - sc_time(gen->late_ns(i, k), SC_NS));
+                    else
+                        src_dropped++;
+                }
+                src_q_max = std::max(src_q_max, src_q[i].size());
+            }
+        }
 
-                // Update round-robin pointer to the next thread
-                current_thread = thread_to_try + 1;
-                if (current_thread > 3)
-                    current_thread = 1;
+        // Send at most one packet per cycle, for the thread the arbiter picks
+        // among those holding credits (and, open-loop, a queued packet)
+        if (traffic_on)
+            window_cycles++;
+        for (int i = 0; i < 3; i++)
+        {
+            const bool wants = gen ? !src_q[i].empty() : traffic_on;
+            if (traffic_on && wants && credit_counter[i] == 0)
+                starved[i]++;
+            req[i] = credit_counter[i] > 0 && wants;
+            stamp[i] = req[i] && !credit_time[i].empty() ? credit_time[i].front().value() : 0;
+        }
+        int idx = arb->pick(req, stamp);
+        if (idx >= 0)
+        {
+            // Create and send a packet for this thread (threads are 1-3)
+            RawTLP pkt;
+            pkt.seq_num = packet_seq;
+            pkt.thread_id = idx + 1;
 
-                break; // Only send one packet per cycle
+            raw_tlp.write(pkt);
+            raw_valid.write(true); // Assert valid for this cycle only
+            std::cout << sc_time_stamp() << " [" << name() << "] " << __FUNCTION__
+                      << " seq_num=" << pkt.seq_num << " thread_id=" << pkt.thread_id;
+            sc_time born = sc_time_stamp();
+            if (gen)
+            {
+                // log the arrival so latency includes source queueing
+                const sc_time arrival = src_q[idx].front();
+                born = arrival;
+                src_q[idx].pop_front();
+                const double wait_ns = (sc_time_stamp() - arrival).to_seconds() * 1e9;
+                src_wait_sum_ns += wait_ns;
+                src_wait_max_ns = std::max(src_wait_max_ns, wait_ns);
+                src_wait_last_ns = wait_ns;
+                std::cout << " arrival_ns=" << static_cast<uint64_t>(arrival.to_seconds() * 1e9 + 0.5);
             }
+            std::cout << std::endl;
+            if (probe)
+                probe->sent(pkt.seq_num.to_uint64(), born);
+
+            // Consume one credit for this thread
+            credit_counter[idx]--;
+            if (!credit_time[idx].empty())
+                credit_time[idx].pop_front();
+            outstanding[idx].push_back(sc_time_stamp());
+            pkts_sent++;
+            sent_per_thread[idx]++;
+            if (first_send_ns < 0)
+                first_send_ns = (sc_time_stamp() - link_up).to_seconds() * 1e9;
+
+            // Increment packet sequence
+            packet_seq++;
         }
     }
 }
@@ -466,133 +1044,828 @@ void iEP::process_popped_data(const RawTLP &pkt, int queue_id)
 
 void iEP::popper_thread()
 {
-    unsigned int pop_counter = 0; // Counter for deterministic popping
-
     while (true)
     {
         wait(clk.posedge_event());
 
-        if (!reset_n.read())
-        {
-            pop_counter = 0;
+        if (!reset_n.read() || !GlobalConfig::enable_popping)
             continue;
-        }
 
-        // Pop from queues when enabled
-        if (GlobalConfig::enable_popping)
-        {
-            std::cout << sc_time_stamp() << " [iEP popper] counter=" << pop_counter << std::endl;
-            RawTLP pkt_temp;
-            threaded_queues->pop_data(0, pkt_temp);
-            process_popped_data(pkt_temp, 0);    
-            threaded_queues->pop_data(1, pkt_temp);
-            process_popped_data(pkt_temp, 1);
-            threaded_queues->pop_data(2, pkt_temp);
-            process_popped_data(pkt_temp, 2);
-            if (pop_counter == 3)
-            { // Pop on every 4th cycle
-                // Randomly select a queue to pop from
-                int random_queue = rand() % 3;
-                RawTLP pkt;
-                if (threaded_queues->pop_data(random_queue, pkt))
-                {
-                    process_popped_data(pkt, random_queue);
-                }
+        // Pop what the consumer model grants; a failed pop ends the queue's turn
+        if (drain)
+            drain->tick();
+        active_cycles++;
+        for (int q = 0; q < 3; q++)
+        {
+            const unsigned grant = drain ? drain->budget(q) : 1;
+            if (grant == 0 && threaded_queues->has_data(q))
+                held_cycles[q]++;
+            unsigned n = 0;
+            RawTLP pkt;
+            while (n < grant && threaded_queues->pop_data(q, pkt))
+            {
+                process_popped_data(pkt, q);
+                if (probe)
+                    probe->popped(pkt.seq_num.to_uint64());
+                n++;
             }
-            pop_counter = (pop_counter + 1) % 4; // Cycle counter 0-3
+            popped[q] += n;
+            if (drain)
+                drain->used(q, n);
         }
     }
 }
 
-void AxiNoC::main_thread()
+void iEP::reverse_thread()
 {
-    wait(SC_ZERO_TIME);
     while (true)
     {
         wait(clk.posedge_event());
 
-        if (!reset_n.read()) {
-            // Reset stall tracking signals
-            stall_active_sig = false;
-            delta_cycle_ctr = 0;
-            pattern_ctr = 0;
-            ready_out.write(false);
-            valid_out.write(false);
-            for(unsigned i = 0; i < PIPE_LAT; i++) {
-                pipe_valid[i] = false;
-            }
+        if (!reset_n.read())
+        {
+            rev_acc = 0;
+            rev_q.clear();
+            rev_valid.write(false);
             continue;
         }
 
-        // Predict stall condition for next cycle
-        const unsigned next_pattern_ctr = (pattern_ctr + 1) % NOC_PATTERN_LEN;
-        const unsigned stall_cycles = (NOC_PATTERN_LEN * NOC_STALL_PCT) / 100;
-        bool next_stall_active = (next_pattern_ctr < stall_cycles);
-
-        // Update stall tracking signals
-        stall_active_sig = next_stall_active;
-        if (stall_active_sig) {
-            delta_cycle_ctr++;
-        } else {
-            delta_cycle_ctr = 0;  // Reset counter when not stalling
-        }
-
-        // Only assert ready if we won't stall next cycle
-        bool ready_ok = !pipe_valid[0] && !next_stall_active;
-        ready_out.write(ready_ok);
-
-        if (valid_in.read() && ready_ok)
+        // the packet driven last cycle is gone once the link was ready for it
+        if (rev_valid.read() && rev_ready.read())
         {
-            pipe[0] = axi_in.read();
-            pipe_valid[0] = true;
-            if (is_main_noc)
-                std::cout << sc_time_stamp() << " [" << name() << "] " << __FUNCTION__
-                          << " ingress seq_num=" << axi_to_tlp(pipe[0]).seq_num << std::endl;
+            rev_q.pop_front();
+            rev_sent++;
         }
 
-        // Update pattern counter for next cycle
-        pattern_ctr = next_pattern_ctr;
-
-        // Drive output when last stage valid
-        if (pipe_valid[PIPE_LAT - 1])
-        {
-            valid_out.write(true);
-            axi_out.write(pipe[PIPE_LAT - 1]);
-            if (is_main_noc)
-                std::cout << sc_time_stamp() << " [" << name() << "] " << __FUNCTION__
-                          << " EGRESS seq_num=" << axi_to_tlp(pipe[PIPE_LAT - 1]).seq_num << std::endl;
-            if (ready_in.read())
-            {
-                pipe_valid[PIPE_LAT - 1] = false;
-                if (is_main_noc)
-                    std::cout << sc_time_stamp() << " [" << name() << "] " << __FUNCTION__
-                              << " ACCEPTED seq_num=" << axi_to_tlp(pipe[PIPE_LAT - 1]).seq_num << std::endl;
-            }
-        }
-        else
+        rev_acc += rev_pct;
+        if (rev_acc >= 100)
         {
-            valid_out.write(false);
+            rev_acc -= 100;
+            RawTLP pkt;
+            pkt.seq_num = rev_seq++;
+            pkt.thread_id = 0;
+            rev_q.push_back(pkt);
+            rev_offered++;
+            if (rev_probe)
+                rev_probe->sent(pkt.seq_num.to_uint64(), sc_time_stamp());
+            if (rev_q.size() > max_rev_backlog)
+                max_rev_backlog = rev_q.size();
         }
 
-        // shift pipeline each clock
-        for (int i = PIPE_LAT - 1; i > 0; --i)
-        {
-            if (!pipe_valid[i] && pipe_valid[i - 1])
-            {
-                pipe[i] = pipe[i - 1];
-                pipe_valid[i] = true;
-                pipe_valid[i - 1] = false;
-            }
-        }
+        rev_valid.write(!rev_q.empty());
+        if (!rev_q.empty())
+            rev_tlp.write(rev_q.front());
+    }
+}
 
-        if (valid_in.read() && !ready_ok && is_main_noc)
-        {
+void iEP::report()
+{
+    std::cout << "\n---- " << name() << " drain (" << (drain ? drain->kind() : "full") << ") ----\n";
+    for (unsigned q = 0; q < 3; ++q)
+        std::cout << "Queue " << q << " : " << popped[q] << " popped, "
+                  << (active_cycles ? 100.0 * popped[q] / active_cycles : 0.0) << " % of cycles, held "
+                  << (active_cycles ? 100.0 * held_cycles[q] / active_cycles : 0.0) << " % with data waiting\n";
+    if (drain)
+        drain->report(std::cout);
+    if (rev_pct)
+        std::cout << "Reverse data       : " << rev_sent << " of " << rev_offered
+                  << " sent (max backlog " << max_rev_backlog << ")\n";
+}
+
+void iEP::clear_stats()
+{
+    for (int i = 0; i < 3; ++i)
+        popped[i] = held_cycles[i] = 0;
+    active_cycles = 0;
+    rev_offered = rev_sent = 0;
+    max_rev_backlog = 0;
+    threaded_queues->clear_stats();
+}
+
+NocLink::NocLink(unsigned latency, unsigned pattern_len, unsigned stall_pct)
+    : PIPE_LAT(latency), NOC_PATTERN_LEN(pattern_len), NOC_STALL_PCT(stall_pct)
+{
+    pipe = new AxiWord[PIPE_LAT];
+    pipe_valid = new bool[PIPE_LAT];
+    for (unsigned i = 0; i < PIPE_LAT; i++)
+    {
+        pipe_valid[i] = false;
+    }
+}
+
+NocLink::~NocLink()
+{
+    delete[] pipe;
+    delete[] pipe_valid;
+}
+
+void NocLink::reset()
+{
+    // Reset stall tracking signals
+    stall_active_sig = false;
+    delta_cycle_ctr = 0;
+    pattern_ctr = 0;
+    for (unsigned i = 0; i < PIPE_LAT; i++)
+    {
+        pipe_valid[i] = false;
+    }
+}
+
+void NocLink::advance()
+{
+    // Predict stall condition for next cycle
+    const unsigned next_pattern_ctr = (pattern_ctr + 1) % NOC_PATTERN_LEN;
+    const unsigned stall_cycles = (NOC_PATTERN_LEN * NOC_STALL_PCT) / 100;
+    bool next_stall_active = (next_pattern_ctr < stall_cycles);
+
+    // Update stall tracking signals
+    stall_active_sig = next_stall_active;
+    if (stall_active_sig) {
+        delta_cycle_ctr++;
+    } else {
+        delta_cycle_ctr = 0;  // Reset counter when not stalling
+    }
+
+    // Update pattern counter for next cycle
+    pattern_ctr = next_pattern_ctr;
+}
+
+void NocLink::shift()
+{
+    // shift pipeline each clock
+    for (int i = PIPE_LAT - 1; i > 0; --i)
+    {
+        if (!pipe_valid[i] && pipe_valid[i - 1])
+        {
+            pipe[i] = pipe[i - 1];
+            pipe_valid[i] = true;
+            pipe_valid[i - 1] = false;
+        }
+    }
+}
+
+void AxiNoC::main_thread()
+{
+    wait(SC_ZERO_TIME);
+    while (true)
+    {
+        wait(clk.posedge_event());
+
+        if (!reset_n.read()) {
+            link.reset();
+            ready_out.write(false);
+            valid_out.write(false);
+            continue;
+        }
+
+        link.advance();
+
+        // A beat transfers when valid and our registered ready were both high
+        // last cycle; ready was only raised with pipe[0] free, so this cannot
+        // overwrite a beat.
+        if (valid_in.read() && ready_out.read())
+        {
+            link.push(axi_in.read());
+            if (is_main_noc)
+                std::cout << sc_time_stamp() << " [" << name() << "] " << __FUNCTION__
+                          << " ingress seq_num=" << axi_to_tlp(link.pipe[0]).seq_num << std::endl;
+        }
+
+        // Retire the beat driven last cycle if the consumer was ready for it
+        if (valid_out.read() && ready_in.read() && link.out_valid())
+        {
+            if (is_main_noc)
+                std::cout << sc_time_stamp() << " [" << name() << "] " << __FUNCTION__
+                          << " ACCEPTED seq_num=" << axi_to_tlp(link.out()).seq_num << std::endl;
+            link.pop();
+        }
+
+        link.shift();
+
+        // Drive output when last stage valid
+        if (link.out_valid())
+        {
+            valid_out.write(true);
+            axi_out.write(link.out());
+            if (is_main_noc)
+                std::cout << sc_time_stamp() << " [" << name() << "] " << __FUNCTION__
+                          << " EGRESS seq_num=" << axi_to_tlp(link.out()).seq_num << std::endl;
+        }
+        else
+        {
+            valid_out.write(false);
+        }
+
+        // Only assert ready if pipe[0] is free and we won't stall next cycle
+        ready_out.write(link.ready());
+    }
+}
+
+void CreditedAxiNoC::reset_hops()
+{
+    ingress.clear();
+    for (auto& h : hops)
+    {
+        h.wire.clear();
+        h.buf.clear();
+        h.credit_wire.clear();
+        h.credits = HOP_BUF;
+    }
+}
+
+void CreditedAxiNoC::main_thread()
+{
+    wait(SC_ZERO_TIME);
+    while (true)
+    {
+        wait(clk.posedge_event());
+        const unsigned stall_cycles = (NOC_PATTERN_LEN * NOC_STALL_PCT) / 100;
+
+        if (!reset_n.read()) {
+            reset_hops();
+            ready_out.write(false);
+            valid_out.write(false);
+            continue;
+        }
+        cycle++;
+
+        // Same handshake rule as AxiNoC: ready was only raised with an
+        // ingress slot free
+        if (valid_in.read() && ready_out.read())
+            ingress.push_back(axi_in.read());
+
+        // Retire the beat driven last cycle; its slot's credit heads upstream
+        CreditedHop& last = hops[HOPS - 1];
+        if (valid_out.read() && ready_in.read() && !last.buf.empty())
+        {
+            last.buf.pop_front();
+            last.credit_wire.push_back(cycle + CREDIT_LAT);
+            delivered++;
+        }
+
+        // Land credits and beats that completed their flight
+        for (auto& h : hops)
+        {
+            while (!h.credit_wire.empty() && h.credit_wire.front() <= cycle)
+            {
+                h.credit_wire.pop_front();
+                h.credits++;
+            }
+            while (!h.wire.empty() && h.wire.front().first <= cycle)
+            {
+                h.buf.push_back(h.wire.front().second);
+                h.wire.pop_front();
+                if (h.buf.size() > h.max_buf)
+                    h.max_buf = h.buf.size();
+            }
+        }
+
+        // Launch at most one beat per hop, downstream first; a beat leaving
+        // hop k-1's buffer returns that slot's credit to stage k-2
+        for (int k = HOPS - 1; k >= 0; --k)
+        {
+            CreditedHop& h = hops[k];
+            std::deque<AxiWord>& src = k == 0 ? ingress : hops[k - 1].buf;
+            if (src.empty())
+                continue;
+            bool stalled = ((cycle + k * NOC_PATTERN_LEN / HOPS) % NOC_PATTERN_LEN) < stall_cycles;
+            if (h.credits == 0)
+            {
+                h.starved++;
+                continue;
+            }
+            if (stalled)
+                continue;
+            h.credits--;
+            h.sent++;
+            h.wire.push_back(std::make_pair(cycle + HOP_LAT, src.front()));
+            src.pop_front();
+            if (k > 0)
+                hops[k - 1].credit_wire.push_back(cycle + CREDIT_LAT);
+        }
+
+        if (!last.buf.empty())
+        {
+            valid_out.write(true);
+            axi_out.write(last.buf.front());
+        }
+        else
+        {
+            valid_out.write(false);
+        }
+
+        ready_out.write(ingress.size() < INGRESS_DEPTH);
+    }
+}
+
+void CreditedAxiNoC::report()
+{
+    std::cout << "\n---- " << name() << " credited hops ----\n";
+    std::cout << "Hops x latency     : " << HOPS << " x " << HOP_LAT << " cycles (credit return "
+              << CREDIT_LAT << ")\n";
+    std::cout << "Buffer entries     : " << buffer_entries() << " (" << HOP_BUF << " per hop)\n";
+    std::cout << "Beats delivered    : " << delivered << "\n";
+    std::cout << "hop  sent  credit_starved  max_buf\n";
+    for (unsigned k = 0; k < HOPS; ++k)
+        std::cout << std::setw(3) << k << std::setw(6) << hops[k].sent
+                  << std::setw(16) << hops[k].starved << std::setw(9) << hops[k].max_buf << "\n";
+}
+
+void CreditedAxiNoC::clear_stats()
+{
+    delivered = 0;
+    for (CreditedHop& h : hops)
+    {
+        h.sent = h.starved = 0;
+        h.max_buf = 0;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Virtual-channel data path
+// -----------------------------------------------------------------------------
+
+void VcTxFIFO::main_thread()
+{
+    wait(SC_ZERO_TIME);
+    while (true)
+    {
+        wait(clk.posedge_event());
+
+        if (!reset_n.read())
+        {
+            for (auto& q : lanes)
+                q.clear();
+            driven_lane = -1;
+            rr = 0;
+            egress_valid.write(false);
+            continue;
+        }
+
+        // retire the beat driven last cycle if its lane was ready
+        sc_uint<3> ready = egress_ready.read();
+        if (driven_lane >= 0 && egress_valid.read() && ready[driven_lane])
+        {
+            const RawTLP& p = lanes[driven_lane].front();
             std::cout << sc_time_stamp() << " [" << name() << "] " << __FUNCTION__
-                      << " DROPPED seq_num=" << axi_to_tlp(axi_in.read()).seq_num << " (backpressure)" << std::endl;
+                      << " Handshake: sent seq_num=" << p.seq_num
+                      << " thread_id=" << p.thread_id << " vc=" << driven_lane << std::endl;
+            lanes[driven_lane].pop_front();
+        }
+        else if (driven_lane >= 0)
+        {
+            // the driven beat is stuck: every other lane with packets waits behind it
+            for (unsigned t = 0; t < 3; ++t)
+                if (static_cast<int>(t) != driven_lane && !lanes[t].empty())
+                {
+                    hol_cycles[t]++;
+                    if (ready[t])
+                        hol_ready_cycles[t]++;
+                }
+        }
+
+        // VC arbiter: round robin over lanes whose ready is high; if none is,
+        // drive a waiting lane anyway so it goes as soon as its ready rises
+        driven_lane = -1;
+        for (unsigned k = 0; k < 3 && driven_lane < 0; ++k)
+        {
+            unsigned t = (rr + k) % 3;
+            if (!lanes[t].empty() && ready[t])
+                driven_lane = t;
+        }
+        for (unsigned k = 0; k < 3 && driven_lane < 0; ++k)
+        {
+            unsigned t = (rr + k) % 3;
+            if (!lanes[t].empty())
+                driven_lane = t;
+        }
+        if (driven_lane >= 0)
+        {
+            rr = (driven_lane + 1) % 3;
+            egress_axi.write(tlp_to_axi(lanes[driven_lane].front()));
+            egress_valid.write(true);
+        }
+        else
+        {
+            egress_valid.write(false);
+        }
+
+        // enqueue from iRC_tx into the thread's lane
+        if (ingress_valid.read())
+        {
+            RawTLP pkt = ingress_tlp.read();
+            auto& q = lanes[thread_lane(pkt)];
+            if (q.size() < LANE_DEPTH)
+            {
+                q.push_back(pkt);
+            }
+            else
+            {
+                dropped++;
+                std::cout << sc_time_stamp() << " [" << name() << "] " << __FUNCTION__
+                          << " DROPPED seq_num=" << pkt.seq_num << " (lane full)" << std::endl;
+            }
+        }
+
+        unsigned cur_occ = lanes[0].size() + lanes[1].size() + lanes[2].size();
+        if (cur_occ > max_occ)
+        {
+            max_occ = cur_occ;
+            std::cout << sc_time_stamp()
+                      << " [" << name() << "_FIFO] depth=" << max_occ << std::endl;
+        }
+    }
+}
+
+void VcAxiNoC::reset_lanes()
+{
+    for (unsigned v = 0; v < 3; ++v)
+    {
+        egress[v].clear();
+        lane_credits[v] = LANE_DEPTH;
+    }
+    driven_lane = -1;
+    rr = 0;
+    lane_stall = 0;
+}
+
+void VcAxiNoC::main_thread()
+{
+    wait(SC_ZERO_TIME);
+    while (true)
+    {
+        wait(clk.posedge_event());
+
+        if (!reset_n.read()) {
+            link.reset();
+            reset_lanes();
+            ready_out.write(0);
+            valid_out.write(false);
+            continue;
+        }
+
+        // Per-lane stall for next cycle: the AxiNoC pattern, phase-shifted by
+        // a third of the pattern per lane
+        link.advance();
+        const unsigned stall_cycles = (link.NOC_PATTERN_LEN * NOC_STALL_PCT) / 100;
+        for (unsigned v = 0; v < 3; ++v)
+            lane_stall[v] = ((link.pattern_ctr + v * link.NOC_PATTERN_LEN / 3) % link.NOC_PATTERN_LEN) < stall_cycles;
+
+        if (valid_in.read())
+        {
+            AxiWord w = axi_in.read();
+            unsigned v = thread_lane(axi_to_tlp(w));
+            if (ready_out.read()[v])
+            {
+                link.push(w);
+                lane_credits[v]--;
+                if (is_main_noc)
+                    std::cout << sc_time_stamp() << " [" << name() << "] " << __FUNCTION__
+                              << " ingress seq_num=" << axi_to_tlp(w).seq_num << " vc=" << v << std::endl;
+            }
+        }
+
+        if (driven_lane >= 0 && valid_out.read() && ready_in.read()[driven_lane])
+        {
+            if (is_main_noc)
+                std::cout << sc_time_stamp() << " [" << name() << "] " << __FUNCTION__
+                          << " ACCEPTED seq_num=" << axi_to_tlp(egress[driven_lane].front()).seq_num << std::endl;
+            egress[driven_lane].pop_front();
+            lane_credits[driven_lane]++;
+        }
+
+        link.shift();
+
+        // pipe output lands in its lane's egress buffer (space reserved at ingress)
+        if (link.out_valid())
+        {
+            egress[thread_lane(axi_to_tlp(link.out()))].push_back(link.out());
+            link.pop();
+        }
+
+        sc_uint<3> ready = ready_in.read();
+        driven_lane = -1;
+        for (unsigned k = 0; k < 3 && driven_lane < 0; ++k)
+        {
+            unsigned v = (rr + k) % 3;
+            if (!egress[v].empty() && ready[v])
+                driven_lane = v;
+        }
+        for (unsigned k = 0; k < 3 && driven_lane < 0; ++k)
+        {
+            unsigned v = (rr + k) % 3;
+            if (!egress[v].empty())
+                driven_lane = v;
+        }
+        if (driven_lane >= 0)
+        {
+            rr = (driven_lane + 1) % 3;
+            const AxiWord& w = egress[driven_lane].front();
+            valid_out.write(true);
+            axi_out.write(w);
+            if (is_main_noc)
+                std::cout << sc_time_stamp() << " [" << name() << "] " << __FUNCTION__
+                          << " EGRESS seq_num=" << axi_to_tlp(w).seq_num << " vc=" << driven_lane << std::endl;
+        }
+        else
+        {
+            valid_out.write(false);
+        }
+
+        sc_uint<3> rdy = 0;
+        for (unsigned v = 0; v < 3; ++v)
+            rdy[v] = link.ready() && !lane_stall[v] && lane_credits[v] > 0;
+        ready_out.write(rdy);
+    }
+}
+
+void VcRxFIFO::main_thread()
+{
+    wait(SC_ZERO_TIME);
+    while (true)
+    {
+        wait(clk.posedge_event());
+
+        if (!reset_n.read())
+        {
+            for (auto& q : lanes)
+                q.clear();
+            rr = 0;
+            ready_out.write(0);
+            valid_out.write(false);
+            continue;
+        }
+
+        if (valid_in.read())
+        {
+            RawTLP p = axi_to_tlp(axi_in.read());
+            unsigned v = thread_lane(p);
+            if (ready_out.read()[v])
+            {
+                lanes[v].push_back(p);
+                std::cout << sc_time_stamp() << " [" << name() << "] " << __FUNCTION__
+                          << " Enqueue seq_num=" << p.seq_num << " thread_id=" << p.thread_id
+                          << " vc=" << v << std::endl;
+            }
+        }
+
+        unsigned int occ = lanes[0].size() + lanes[1].size() + lanes[2].size();
+        if (occ > max_occ)
+        {
+            max_occ = occ;
+            std::cout << sc_time_stamp() << " [" << name() << "_FIFO] depth=" << max_occ << std::endl;
+        }
+
+        // round robin over non-empty lanes toward iEP_after_RX
+        bool sent = false;
+        for (unsigned k = 0; k < 3 && !sent; ++k)
+        {
+            unsigned v = (rr + k) % 3;
+            if (!lanes[v].empty())
+            {
+                tlp_out.write(lanes[v].front());
+                lanes[v].pop_front();
+                rr = (v + 1) % 3;
+                sent = true;
+            }
+        }
+        valid_out.write(sent);
+
+        sc_uint<3> rdy = 0;
+        for (unsigned v = 0; v < 3; ++v)
+            rdy[v] = lanes[v].size() < LANE_DEPTH;
+        ready_out.write(rdy);
+    }
+}
+
+void MeshNoC::set_route(unsigned src, unsigned dst)
+{
+    dest_of[src] = static_cast<int>(dst);
+}
+
+int MeshNoC::neighbour(unsigned node, unsigned dir) const
+{
+    int x = node % DIM_X;
+    int y = node / DIM_X;
+    switch (dir)
+    {
+    case PORT_NORTH: y--; break;
+    case PORT_SOUTH: y++; break;
+    case PORT_EAST:  x++; break;
+    case PORT_WEST:  x--; break;
+    default: return -1;
+    }
+    if (TORUS)
+    {
+        x = (x + DIM_X) % DIM_X;
+        y = (y + DIM_Y) % DIM_Y;
+    }
+    else if (x < 0 || y < 0 || x >= static_cast<int>(DIM_X) || y >= static_cast<int>(DIM_Y))
+    {
+        return -1;
+    }
+    return node_id(x, y);
+}
+
+// Dimension-order (XY) routing; on a torus each dimension takes the shorter way round.
+unsigned MeshNoC::route(unsigned node, unsigned dst) const
+{
+    const unsigned x = node % DIM_X, y = node / DIM_X;
+    const unsigned dx = dst % DIM_X, dy = dst / DIM_X;
+    if (dx != x)
+    {
+        if (TORUS)
+            return ((dx + DIM_X - x) % DIM_X) <= DIM_X / 2 ? PORT_EAST : PORT_WEST;
+        return dx > x ? PORT_EAST : PORT_WEST;
+    }
+    if (dy != y)
+    {
+        if (TORUS)
+            return ((dy + DIM_Y - y) % DIM_Y) <= DIM_Y / 2 ? PORT_SOUTH : PORT_NORTH;
+        return dy > y ? PORT_SOUTH : PORT_NORTH;
+    }
+    return PORT_LOCAL;
+}
+
+unsigned MeshNoC::hops(unsigned src, unsigned dst) const
+{
+    unsigned n = 0;
+    for (unsigned node = src; node != dst; ++n)
+        node = neighbour(node, route(node, dst));
+    return n;
+}
+
+void MeshNoC::main_thread()
+{
+    static const unsigned opposite[NUM_PORTS] = {PORT_LOCAL, PORT_SOUTH, PORT_WEST, PORT_NORTH, PORT_EAST};
+    const unsigned n = num_nodes();
+
+    wait(SC_ZERO_TIME);
+    while (true)
+    {
+        wait(clk.posedge_event());
+
+        if (!reset_n.read())
+        {
+            for (auto* l : links)
+                if (l)
+                    l->reset();
+            for (unsigned node = 0; node < n; ++node)
+            {
+                inj_links[node]->reset();
+                ej_links[node]->reset();
+                for (auto& q : routers[node].in_buf)
+                    q.clear();
+                std::fill(std::begin(routers[node].rr), std::end(routers[node].rr), 0u);
+                inj_ready[node].write(false);
+                ej_valid[node].write(false);
+            }
+            continue;
+        }
+
+        for (auto* l : links)
+            if (l)
+                l->advance();
+        for (unsigned node = 0; node < n; ++node)
+        {
+            inj_links[node]->advance();
+            ej_links[node]->advance();
+        }
+
+        // Local ports follow the AxiNoC handshake: retire the beat driven last
+        // cycle, accept against the ready we registered last cycle.
+        for (unsigned node = 0; node < n; ++node)
+        {
+            NocLink* ej = ej_links[node];
+            if (ej_valid[node].read() && ej_ready[node].read() && ej->out_valid())
+            {
+                ej->pop();
+                ejected[node]++;
+            }
+            if (inj_valid[node].read() && inj_ready[node].read() && dest_of[node] >= 0)
+            {
+                AxiWord w = inj_axi[node].read();
+                axi_set_dest(w, dest_of[node]);
+                inj_links[node]->push(w);
+                injected[node]++;
+            }
+        }
+
+        // Switch traversal: each output grants one input head per cycle, round robin
+        for (unsigned node = 0; node < n; ++node)
+        {
+            Router& r = routers[node];
+            bool in_used[NUM_PORTS] = {false, false, false, false, false};
+            for (unsigned o = 0; o < NUM_PORTS; ++o)
+            {
+                NocLink* out = (o == PORT_LOCAL) ? ej_links[node] : links[node * 4 + o - 1];
+                bool out_ok = out && out->ready();
+                bool granted = false;
+                for (unsigned k = 0; k < NUM_PORTS; ++k)
+                {
+                    unsigned i = (r.rr[o] + k) % NUM_PORTS;
+                    if (in_used[i] || r.in_buf[i].empty())
+                        continue;
+                    if (route(node, axi_get_dest(r.in_buf[i].front())) != o)
+                        continue;
+                    if (granted)
+                    {
+                        arb_losses++;
+                        continue;
+                    }
+                    if (!out_ok)
+                    {
+                        link_blocked++;
+                        break;
+                    }
+                    out->push(r.in_buf[i].front());
+                    r.in_buf[i].pop_front();
+                    in_used[i] = true;
+                    r.rr[o] = (i + 1) % NUM_PORTS;
+                    granted = true;
+                    if (o != PORT_LOCAL)
+                        link_flits++;
+                }
+            }
+        }
+
+        // Link delivery into the downstream router's input buffer
+        for (unsigned node = 0; node < n; ++node)
+        {
+            for (unsigned dir = PORT_NORTH; dir <= PORT_WEST; ++dir)
+            {
+                NocLink* l = links[node * 4 + dir - 1];
+                if (!l || !l->out_valid())
+                    continue;
+                auto& buf = routers[neighbour(node, dir)].in_buf[opposite[dir]];
+                if (buf.size() < BUF_DEPTH)
+                {
+                    buf.push_back(l->out());
+                    l->pop();
+                }
+            }
+            auto& local = routers[node].in_buf[PORT_LOCAL];
+            if (inj_links[node]->out_valid() && local.size() < BUF_DEPTH)
+            {
+                local.push_back(inj_links[node]->out());
+                inj_links[node]->pop();
+            }
+            for (auto& q : routers[node].in_buf)
+                if (q.size() > max_buf_occ)
+                    max_buf_occ = q.size();
+        }
+
+        for (auto* l : links)
+            if (l)
+                l->shift();
+        for (unsigned node = 0; node < n; ++node)
+        {
+            inj_links[node]->shift();
+            ej_links[node]->shift();
+
+            NocLink* ej = ej_links[node];
+            if (ej->out_valid())
+            {
+                AxiWord w = ej->out();
+                axi_set_dest(w, 0);
+                ej_valid[node].write(true);
+                ej_axi[node].write(w);
+            }
+            else
+            {
+                ej_valid[node].write(false);
+            }
+            inj_ready[node].write(inj_links[node]->ready());
         }
     }
 }
 
+void MeshNoC::report()
+{
+    std::cout << "\n---- " << name() << " (" << DIM_X << "x" << DIM_Y
+              << (TORUS ? " torus" : " mesh") << ") ----\n";
+    uint64_t inj = 0, ej = 0;
+    for (unsigned node = 0; node < num_nodes(); ++node)
+    {
+        inj += injected[node];
+        ej += ejected[node];
+    }
+    std::cout << "Beats injected     : " << inj << "\n";
+    std::cout << "Beats ejected      : " << ej << "\n";
+    std::cout << "Link traversals    : " << link_flits << "\n";
+    std::cout << "Arbitration losses : " << arb_losses << "\n";
+    std::cout << "Link-blocked heads : " << link_blocked << "\n";
+    std::cout << "Max input buffer   : " << max_buf_occ << "/" << BUF_DEPTH << "\n";
+}
+
+void MeshNoC::clear_stats()
+{
+    std::fill(injected.begin(), injected.end(), 0);
+    std::fill(ejected.begin(), ejected.end(), 0);
+    link_flits = arb_losses = link_blocked = 0;
+    max_buf_occ = 0;
+}
+
 void CreditDutyMon::sample()
 {
     total++;
@@ -602,6 +1875,119 @@ void CreditDutyMon::sample()
         hi_hybrid++;
 }
 
+void SimpleTxFIFO::report()
+{
+    std::cout << "\n---- " << name() << " head-of-line blocking ("
+              << (VOQ ? std::string("per-thread VOQ, ") + arb->kind() : std::string("shared FIFO")) << ") ----\n";
+    for (unsigned t = 0; t < 3; ++t)
+        std::cout << "Thread " << t + 1 << " : " << hol_cycles[t] << " cycles\n";
+
+    const std::streamsize prec = std::cout.precision();
+    std::cout << "\n---- " << name() << " per-thread occupancy / wait ----\n";
+    std::cout << "thread  avg_occ  max_occ     sent  avg_wait_ns  max_wait_ns\n";
+    for (unsigned t = 0; t < 3; ++t)
+    {
+        std::cout << std::setw(6) << t + 1
+                  << std::setw(9) << std::fixed << std::setprecision(2)
+                  << (cycles ? static_cast<double>(occ_sum[t]) / cycles : 0.0)
+                  << std::setw(9) << max_queued[t]
+                  << std::setw(9) << sent[t]
+                  << std::setw(13) << std::setprecision(1) << (sent[t] ? wait_sum_ns[t] / sent[t] : 0.0)
+                  << std::setw(13) << wait_max_ns[t] << "\n";
+    }
+    std::cout.unsetf(std::ios::fixed);
+    std::cout.precision(prec);
+    if (dropped)
+        std::cout << "Dropped at ingress : " << dropped << " (FIFO full)\n";
+}
+
+void SimpleTxFIFO::clear_stats()
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        hol_cycles[i] = occ_sum[i] = sent[i] = 0;
+        max_queued[i] = 0;
+        wait_sum_ns[i] = wait_max_ns[i] = 0.0;
+    }
+    cycles = dropped = 0;
+    hs_min = UINT64_MAX;
+    max_occ = 0;
+}
+
+void VcTxFIFO::report()
+{
+    std::cout << "\n---- " << name() << " head-of-line blocking (per-thread VCs) ----\n";
+    for (unsigned t = 0; t < 3; ++t)
+        std::cout << "Thread " << t + 1 << " : " << hol_cycles[t] << " cycles ("
+                  << hol_ready_cycles[t] << " with its lane ready)\n";
+    if (dropped)
+        std::cout << "Dropped at ingress : " << dropped << " (lane full)\n";
+}
+
+void VcTxFIFO::clear_stats()
+{
+    for (int i = 0; i < 3; ++i)
+        hol_cycles[i] = hol_ready_cycles[i] = 0;
+    max_occ = 0;
+    dropped = 0;
+}
+
+void iRC::report()
+{
+    std::cout << "\n---- " << name() << " arbitration (" << arb->kind() << ") ----\n";
+    for (unsigned t = 0; t < 3; ++t)
+        std::cout << "Thread " << t + 1 << " : " << sent_per_thread[t] << " packets ("
+                  << (pkts_sent ? 100.0 * sent_per_thread[t] / pkts_sent : 0.0) << " %)\n";
+    if (window_cycles)
+        std::cout << "Credit-starved : " << 100.0 * starved[0] / window_cycles << " / "
+                  << 100.0 * starved[1] / window_cycles << " / " << 100.0 * starved[2] / window_cycles
+                  << " % of cycles (threads 1/2/3)\n";
+    if (rtt_samples)
+        std::cout << "Credit RTT : " << avg_rtt_ns() << " ns avg, " << rtt_max_ns << " ns max\n";
+    if (first_send_ns >= 0)
+        std::cout << "Link-up to first send       : " << first_send_ns << " ns\n";
+    if (full_window_ns >= 0)
+        std::cout << "Link-up to full credit window : " << full_window_ns << " ns\n";
+    if (rev_received)
+    {
+        std::cout << "Reverse data received : " << rev_received;
+        if (rev_probe && rev_probe->samples)
+            std::cout << " (" << rev_probe->sum_ns / rev_probe->samples << " ns avg from the EP)";
+        std::cout << "\n";
+    }
+    if (!gen)
+        return;
+
+    std::cout << "\n---- " << name() << " traffic (" << gen->kind() << ") ----\n";
+    uint64_t total = 0;
+    for (unsigned t = 0; t < 3; ++t)
+    {
+        total += offered[t];
+        std::cout << "Thread " << t + 1 << " : rate " << gen->rate_of(t) << " pkt/cycle, offered "
+                  << offered[t] << ", queued " << src_q[t].size() << "\n";
+    }
+    std::cout << "Offered / sent : " << total << " / " << pkts_sent << " packets\n";
+    // for a trace this wait is how far the sends lag the recorded schedule
+    std::cout << "Source queue wait : " << (pkts_sent ? src_wait_sum_ns / pkts_sent : 0.0)
+              << " ns avg, " << src_wait_max_ns << " ns max, " << src_wait_last_ns << " ns at the last send\n";
+    std::cout << "Source queue peak : " << src_q_max << " (dropped " << src_dropped << ")\n";
+    gen->report(std::cout);
+}
+
+void iRC::clear_stats()
+{
+    pkts_sent = rtt_samples = 0;
+    rtt_sum_ns = rtt_max_ns = 0.0;
+    rtt_min_ns = -1.0;
+    for (int i = 0; i < 3; ++i)
+        sent_per_thread[i] = offered[i] = starved[i] = 0;
+    src_dropped = 0;
+    src_q_max = 0;
+    src_wait_sum_ns = src_wait_max_ns = src_wait_last_ns = 0.0;
+    window_cycles = 0;
+    rev_received = 0;
+}
+
 void CreditDutyMon::report()
 {
     std::cout << "\n---- Credit bus duty cycle ----\n";
@@ -616,6 +2002,232 @@ void CreditDutyMon::report()
     std::cout << "Hybrid bus : " << pct(hi_hybrid) << " %\n";
 }
 
+void CreditDutyMon::clear_stats()
+{
+    total = hi_direct = hi_hybrid = 0;
+}
+
+// ============================================================================
+// CHECKPOINT IMPLEMENTATIONS
+// ============================================================================
+
+// Model lines carry the model kind first.  A model of another kind (changed
+// on the command line of the restored run) keeps its fresh state.
+template <class M>
+static void save_model(std::ostream& os, const std::string& name, const M* m)
+{
+    os << name << ' ' << (m ? m->kind() : "none");
+    if (m)
+        m->save(os);
+    os << '\n';
+}
+
+template <class M>
+static void load_model(const CheckpointIn& ck, const std::string& name, M* m)
+{
+    std::istringstream is = ck.section(name);
+    std::string kind;
+    is >> kind;
+    if (!m || kind != m->kind())
+    {
+        std::cout << "*** " << name << ": checkpoint holds a '" << kind << "' model, starting '"
+                  << (m ? m->kind() : "none") << "' afresh ***" << std::endl;
+        return;
+    }
+    m->load(is);
+    CheckpointIn::check(is, name);
+}
+
+void LatencyProbe::save(std::ostream& os, const std::string& name) const
+{
+    os << name;
+    ckpt_save(os, samples, sum_ns);
+    ckpt_put(os, inflight.size());
+    for (const auto& kv : inflight)
+        ckpt_save(os, kv.first, kv.second);
+    os << '\n';
+}
+
+void LatencyProbe::load(const CheckpointIn& ck, const std::string& name)
+{
+    std::istringstream is = ck.section(name);
+    size_t n = 0;
+    ckpt_load(is, samples, sum_ns, n);
+    inflight.clear();
+    for (size_t i = 0; i < n && is; ++i)
+    {
+        uint64_t seq = 0;
+        sc_time t;
+        ckpt_load(is, seq, t);
+        inflight[seq] = t;
+    }
+    CheckpointIn::check(is, name);
+}
+
+void Threaded_Queue::save_state(std::ostream& os) const
+{
+    ckpt_save_line(os, name(), fifo, credits, credit_pending, linked, cycle, sent_at, unspent, credit_out);
+}
+
+void Threaded_Queue::load_state(const CheckpointIn& ck)
+{
+    ckpt_load_line(ck, name(), fifo, credits, credit_pending, linked, cycle, sent_at, unspent, credit_out);
+}
+
+void ThreadedFrontEnd::save_state(std::ostream& os) const
+{
+    ckpt_save_line(os, name(), pkts_routed, pkts_popped, max_occ, max_outstanding,
+                   tlp_signals, valid_signals, credit_out);
+    if (pool)
+        ckpt_save_line(os, std::string(name()) + ".pool", pool->outstanding, pool->loop);
+    for (int i = 0; i < 3; ++i)
+        queues[i]->save_state(os);
+}
+
+void ThreadedFrontEnd::load_state(const CheckpointIn& ck)
+{
+    ckpt_load_line(ck, name(), pkts_routed, pkts_popped, max_occ, max_outstanding,
+                   tlp_signals, valid_signals, credit_out);
+    if (pool)
+        ckpt_load_line(ck, std::string(name()) + ".pool", pool->outstanding, pool->loop);
+    for (int i = 0; i < 3; ++i)
+        queues[i]->load_state(ck);
+}
+
+void SimpleTxFIFO::save_state(std::ostream& os) const
+{
+    ckpt_save_line(os, name(), fifo, voq, enq_time, queued, hol_cycles, cycles, occ_sum, max_queued,
+                   sent, wait_sum_ns, wait_max_ns, dropped, drive_cycle, hs_min, max_occ,
+                   holding, held_pkt, held_enq, egress_valid, egress_axi);
+    if (VOQ)
+        save_model(os, std::string(name()) + ".arb", arb);
+}
+
+void SimpleTxFIFO::load_state(const CheckpointIn& ck)
+{
+    ckpt_load_line(ck, name(), fifo, voq, enq_time, queued, hol_cycles, cycles, occ_sum, max_queued,
+                   sent, wait_sum_ns, wait_max_ns, dropped, drive_cycle, hs_min, max_occ,
+                   holding, held_pkt, held_enq, egress_valid, egress_axi);
+    if (VOQ)
+        load_model(ck, std::string(name()) + ".arb", arb);
+}
+
+void SimpleRxFIFO::save_state(std::ostream& os) const
+{
+    ckpt_save_line(os, name(), fifo, max_occ, ready_out, valid_out, tlp_out);
+}
+
+void SimpleRxFIFO::load_state(const CheckpointIn& ck)
+{
+    ckpt_load_line(ck, name(), fifo, max_occ, ready_out, valid_out, tlp_out);
+}
+
+void CreditTx::save_state(std::ostream& os) const
+{
+    ckpt_save_line(os, name(), accum, ctr, sending, pending, window, idle, stalled,
+                   beats, empty_beats, credits_sent, hold_sum, stall_sum, urgent_beats, idle_beats,
+                   window_sum, rev_held, rev_pkt, rev_beats, piggy_beats, piggy_credits, valid_out, axi_out,
+                   rev_ready_out);
+}
+
+void CreditTx::load_state(const CheckpointIn& ck)
+{
+    ckpt_load_line(ck, name(), accum, ctr, sending, pending, window, idle, stalled,
+                   beats, empty_beats, credits_sent, hold_sum, stall_sum, urgent_beats, idle_beats,
+                   window_sum, rev_held, rev_pkt, rev_beats, piggy_beats, piggy_credits, valid_out, axi_out,
+                   rev_ready_out);
+}
+
+void CreditRx::save_state(std::ostream& os) const
+{
+    ckpt_save_line(os, name(), emit_cnt, cycles, beats, credits_out, stall_cycles, max_backlog,
+                   rev_data, ready_out, credit_out, rev_valid_out, rev_tlp_out);
+}
+
+void CreditRx::load_state(const CheckpointIn& ck)
+{
+    ckpt_load_line(ck, name(), emit_cnt, cycles, beats, credits_out, stall_cycles, max_backlog,
+                   rev_data, ready_out, credit_out, rev_valid_out, rev_tlp_out);
+}
+
+void iRC::save_state(std::ostream& os) const
+{
+    ckpt_save_line(os, name(), packet_seq, credit_counter, outstanding, initial_left, pkts_sent,
+                   rtt_samples, rtt_sum_ns, rtt_max_ns, rtt_min_ns, in_reset, link_up, first_send_ns,
+                   full_window_ns, credit_time, sent_per_thread, src_q, offered, src_dropped, src_q_max,
+                   src_wait_sum_ns, src_wait_max_ns, src_wait_last_ns, starved, window_cycles,
+                   rev_received, raw_valid, raw_tlp);
+    save_model(os, std::string(name()) + ".arb", arb);
+    save_model(os, std::string(name()) + ".traffic", gen);
+}
+
+void iRC::load_state(const CheckpointIn& ck)
+{
+    ckpt_load_line(ck, name(), packet_seq, credit_counter, outstanding, initial_left, pkts_sent,
+                   rtt_samples, rtt_sum_ns, rtt_max_ns, rtt_min_ns, in_reset, link_up, first_send_ns,
+                   full_window_ns, credit_time, sent_per_thread, src_q, offered, src_dropped, src_q_max,
+                   src_wait_sum_ns, src_wait_max_ns, src_wait_last_ns, starved, window_cycles,
+                   rev_received, raw_valid, raw_tlp);
+    load_model(ck, std::string(name()) + ".arb", arb);
+    load_model(ck, std::string(name()) + ".traffic", gen);
+}
+
+void iEP::save_state(std::ostream& os) const
+{
+    ckpt_save_line(os, name(), popped, held_cycles, active_cycles, rev_acc, rev_seq, rev_q, rev_offered,
+                   rev_sent, max_rev_backlog, rev_valid, rev_tlp);
+    save_model(os, std::string(name()) + ".drain", drain);
+    threaded_queues->save_state(os);
+}
+
+void iEP::load_state(const CheckpointIn& ck)
+{
+    ckpt_load_line(ck, name(), popped, held_cycles, active_cycles, rev_acc, rev_seq, rev_q, rev_offered,
+                   rev_sent, max_rev_backlog, rev_valid, rev_tlp);
+    load_model(ck, std::string(name()) + ".drain", drain);
+    threaded_queues->load_state(ck);
+}
+
+void NocLink::save(std::ostream& os) const
+{
+    for (unsigned i = 0; i < PIPE_LAT; i++)
+        ckpt_save(os, pipe[i], pipe_valid[i]);
+    ckpt_save(os, delta_cycle_ctr, stall_active_sig, pattern_ctr);
+}
+
+void NocLink::load(std::istream& is)
+{
+    for (unsigned i = 0; i < PIPE_LAT; i++)
+        ckpt_load(is, pipe[i], pipe_valid[i]);
+    ckpt_load(is, delta_cycle_ctr, stall_active_sig, pattern_ctr);
+}
+
+void AxiNoC::save_state(std::ostream& os) const
+{
+    os << name();
+    link.save(os);
+    ckpt_save(os, ready_out, valid_out, axi_out);
+    os << '\n';
+}
+
+void AxiNoC::load_state(const CheckpointIn& ck)
+{
+    std::istringstream is = ck.section(name());
+    link.load(is);
+    ckpt_load(is, ready_out, valid_out, axi_out);
+    CheckpointIn::check(is, name());
+}
+
+void CreditDutyMon::save_state(std::ostream& os) const
+{
+    ckpt_save_line(os, name(), total, hi_direct, hi_hybrid);
+}
+
+void CreditDutyMon::load_state(const CheckpointIn& ck)
+{
+    ckpt_load_line(ck, name(), total, hi_direct, hi_hybrid);
+}
+
 // ============================================================================
 // TRACING IMPLEMENTATIONS
 // ============================================================================
@@ -676,6 +2288,47 @@ void SimpleRxFIFO::setup_tracing(bool enable) {
     }
 }
 
+void CreditedRxFIFO::setup_tracing(bool enable) {
+    enable_tracing = enable;
+    if (enable_tracing && !trace_file) {
+        std::string trace_name = "module_traces/" + std::string(name()) + "_trace";
+        trace_file = sc_create_vcd_trace_file(trace_name.c_str());
+        trace_file->set_time_unit(1, SC_NS);
+
+        sc_trace(trace_file, clk, "clk");
+        sc_trace(trace_file, reset_n, "reset_n");
+        sc_trace(trace_file, valid_in, "valid_in");
+        sc_trace(trace_file, axi_in, "axi_in");
+        sc_trace(trace_file, ready_out, "ready_out");
+        sc_trace(trace_file, valid_out, "valid_out");
+        sc_trace(trace_file, tlp_out, "tlp_out");
+        sc_trace(trace_file, ep_credit_in, "ep_credit_in");
+        sc_trace(trace_file, credit_out, "credit_out");
+
+        std::cout << "Created trace file: " << trace_name << ".vcd for " << name() << std::endl;
+    }
+}
+
+void CreditedAxiNoC::setup_tracing(bool enable) {
+    enable_tracing = enable;
+    if (enable_tracing && !trace_file) {
+        std::string trace_name = "module_traces/" + std::string(name()) + "_trace";
+        trace_file = sc_create_vcd_trace_file(trace_name.c_str());
+        trace_file->set_time_unit(1, SC_NS);
+
+        sc_trace(trace_file, clk, "clk");
+        sc_trace(trace_file, reset_n, "reset_n");
+        sc_trace(trace_file, valid_in, "valid_in");
+        sc_trace(trace_file, axi_in, "axi_in");
+        sc_trace(trace_file, ready_out, "ready_out");
+        sc_trace(trace_file, valid_out, "valid_out");
+        sc_trace(trace_file, axi_out, "axi_out");
+        sc_trace(trace_file, ready_in, "ready_in");
+
+        std::cout << "Created trace file: " << trace_name << ".vcd for " << name() << std::endl;
+    }
+}
+
 void CreditTx::setup_tracing(bool enable) {
     enable_tracing = enable;
     if (enable_tracing && !trace_file) {
@@ -689,6 +2342,8 @@ void CreditTx::setup_tracing(bool enable) {
         sc_trace(trace_file, valid_out, "valid_out");
         sc_trace(trace_file, axi_out, "axi_out");
         sc_trace(trace_file, ready_in, "ready_in");
+        sc_trace(trace_file, rev_valid_in, "rev_valid_in");
+        sc_trace(trace_file, rev_ready_out, "rev_ready_out");
         
         std::cout << "Created trace file: " << trace_name << ".vcd for " << name() << std::endl;
     }
@@ -707,6 +2362,7 @@ void CreditRx::setup_tracing(bool enable) {
         sc_trace(trace_file, axi_in, "axi_in");
         sc_trace(trace_file, ready_out, "ready_out");
         sc_trace(trace_file, credit_out, "credit_out");
+        sc_trace(trace_file, rev_valid_out, "rev_valid_out");
         
         std::cout << "Created trace file: " << trace_name << ".vcd for " << name() << std::endl;
     }
@@ -761,13 +2417,72 @@ void AxiNoC::setup_tracing(bool enable) {
         sc_trace(trace_file, valid_out, "valid_out");
         sc_trace(trace_file, axi_out, "axi_out");
         sc_trace(trace_file, ready_in, "ready_in");
-        sc_trace(trace_file, stall_active_sig, "stall_active_sig");
-        sc_trace(trace_file, delta_cycle_ctr, "delta_cycle_ctr");
+        sc_trace(trace_file, link.stall_active_sig, "stall_active_sig");
+        sc_trace(trace_file, link.delta_cycle_ctr, "delta_cycle_ctr");
         
         std::cout << "Created trace file: " << trace_name << ".vcd for " << name() << std::endl;
     }
 }
 
+void VcTxFIFO::setup_tracing(bool enable) {
+    enable_tracing = enable;
+    if (enable_tracing && !trace_file) {
+        std::string trace_name = "module_traces/" + std::string(name()) + "_trace";
+        trace_file = sc_create_vcd_trace_file(trace_name.c_str());
+        trace_file->set_time_unit(1, SC_NS);
+
+        sc_trace(trace_file, clk, "clk");
+        sc_trace(trace_file, reset_n, "reset_n");
+        sc_trace(trace_file, ingress_valid, "ingress_valid");
+        sc_trace(trace_file, ingress_tlp, "ingress_tlp");
+        sc_trace(trace_file, egress_valid, "egress_valid");
+        sc_trace(trace_file, egress_axi, "egress_axi");
+        sc_trace(trace_file, egress_ready, "egress_ready");
+
+        std::cout << "Created trace file: " << trace_name << ".vcd for " << name() << std::endl;
+    }
+}
+
+void VcAxiNoC::setup_tracing(bool enable) {
+    enable_tracing = enable;
+    if (enable_tracing && !trace_file) {
+        std::string trace_name = "module_traces/" + std::string(name()) + "_trace";
+        trace_file = sc_create_vcd_trace_file(trace_name.c_str());
+        trace_file->set_time_unit(1, SC_NS);
+
+        sc_trace(trace_file, clk, "clk");
+        sc_trace(trace_file, reset_n, "reset_n");
+        sc_trace(trace_file, valid_in, "valid_in");
+        sc_trace(trace_file, axi_in, "axi_in");
+        sc_trace(trace_file, ready_out, "ready_out");
+        sc_trace(trace_file, valid_out, "valid_out");
+        sc_trace(trace_file, axi_out, "axi_out");
+        sc_trace(trace_file, ready_in, "ready_in");
+        sc_trace(trace_file, lane_stall, "lane_stall");
+
+        std::cout << "Created trace file: " << trace_name << ".vcd for " << name() << std::endl;
+    }
+}
+
+void VcRxFIFO::setup_tracing(bool enable) {
+    enable_tracing = enable;
+    if (enable_tracing && !trace_file) {
+        std::string trace_name = "module_traces/" + std::string(name()) + "_trace";
+        trace_file = sc_create_vcd_trace_file(trace_name.c_str());
+        trace_file->set_time_unit(1, SC_NS);
+
+        sc_trace(trace_file, clk, "clk");
+        sc_trace(trace_file, reset_n, "reset_n");
+        sc_trace(trace_file, valid_in, "valid_in");
+        sc_trace(trace_file, axi_in, "axi_in");
+        sc_trace(trace_file, ready_out, "ready_out");
+        sc_trace(trace_file, valid_out, "valid_out");
+        sc_trace(trace_file, tlp_out, "tlp_out");
+
+        std::cout << "Created trace file: " << trace_name << ".vcd for " << name() << std::endl;
+    }
+}
+
 void CreditDutyMon::setup_tracing(bool enable) {
     enable_tracing = enable;
     if (enable_tracing && !trace_file) {
@@ -782,3 +2497,24 @@ void CreditDutyMon::setup_tracing(bool enable) {
         std::cout << "Created trace file: " << trace_name << ".vcd for " << name() << std::endl;
     }
 }
+
+void MeshNoC::setup_tracing(bool enable) {
+    enable_tracing = enable;
+    if (enable_tracing && !trace_file) {
+        std::string trace_name = "module_traces/" + std::string(name()) + "_trace";
+        trace_file = sc_create_vcd_trace_file(trace_name.c_str());
+        trace_file->set_time_unit(1, SC_NS);
+
+        sc_trace(trace_file, clk, "clk");
+        sc_trace(trace_file, reset_n, "reset_n");
+        for (unsigned node = 0; node < num_nodes(); ++node) {
+            std::string n = "node" + std::to_string(node);
+            sc_trace(trace_file, inj_valid[node], n + ".inj_valid");
+            sc_trace(trace_file, inj_ready[node], n + ".inj_ready");
+            sc_trace(trace_file, ej_valid[node], n + ".ej_valid");
+            sc_trace(trace_file, ej_ready[node], n + ".ej_ready");
+        }
+
+        std::cout << "Created trace file: " << trace_name << ".vcd for " << name() << std::endl;
+    }
+}
@@ -2,22 +2,92 @@
 #define MODULES_H
 
 #include <systemc.h>
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
+#include <vector>
 #include "payloads.h"
 #include "config.h"
+#include "arbiter.h"
+#include "traffic.h"
+#include "drain.h"
+
+class CheckpointIn;
+
+// -----------------------------------------------------------------------------
+// LatencyProbe: in-simulator end-to-end latency of one path.  The iRC stamps
+// each packet when it is created (its arrival, with open-loop traffic) and the
+// iEP closes the sample when the consumer pops it.  Only packets in flight
+// are held.
+// -----------------------------------------------------------------------------
+
+struct LatencyProbe {
+    std::unordered_map<uint64_t, sc_time> inflight;   // seq -> creation time
+    uint64_t samples = 0;
+    double   sum_ns = 0.0;
+
+    void sent(uint64_t seq, const sc_time& t) { inflight[seq] = t; }
+    void popped(uint64_t seq) {
+        auto it = inflight.find(seq);
+        if (it == inflight.end())
+            return;
+        sum_ns += (sc_time_stamp() - it->second).to_seconds() * 1e9;
+        samples++;
+        inflight.erase(it);
+    }
+
+    void save(std::ostream& os, const std::string& name) const;
+    void load(const CheckpointIn& ck, const std::string& name);
+};
+
+// -----------------------------------------------------------------------------
+// SharedCreditPool: endpoint buffer shared by the three thread queues.  Every
+// thread is guaranteed MIN_PER_THREAD entries and may borrow from SHARED more
+// while it spends its credits (see Threaded_Queue::main_thread).  A credit is only
+// advertised once its slot is reserved here, so outstanding credits
+// (advertised, not yet popped) never exceed the pool size.
+// -----------------------------------------------------------------------------
+
+struct SharedCreditPool {
+    const unsigned MIN_PER_THREAD;
+    const unsigned SHARED;
+    unsigned outstanding[3] = {0, 0, 0};
+    uint64_t loop = 0;   // shortest credit issue-to-arrival seen, in cycles (0: none yet)
+
+    SharedCreditPool(unsigned min_per_thread, unsigned shared)
+        : MIN_PER_THREAD(min_per_thread), SHARED(shared) {}
+
+    unsigned size() const { return 3 * MIN_PER_THREAD + SHARED; }
+    unsigned shared_in_use() const;
+    // Reserve a slot for one more credit of 'lane'; false if none is free.
+    bool try_reserve(unsigned lane);
+    void release(unsigned lane) { if (outstanding[lane] > 0) outstanding[lane]--; }
+    void saw_loop(uint64_t cycles) { if (loop == 0 || cycles < loop) loop = cycles; }
+};
 
 SC_MODULE(Threaded_Queue) {
     sc_in<bool> clk;
     sc_in<bool> reset_n;
     sc_in<RawTLP> raw_tlp_in;
     sc_in<bool> valid_in;
-    sc_out<bool> credit_out;
+    sc_out<unsigned> credit_out;   // credits issued this cycle
 
-    sc_fifo<RawTLP> fifo;
+    TlpFifo fifo;
     const unsigned int capacity;
     
     // Credit state
     unsigned int credits;
     bool credit_pending;
+    bool linked = false;   // initial advertisement done since the last reset
+    // Pool mode: cycle of the last arrival (0: none since reset) and the issue
+    // cycle of each credit no arrival has spent yet, oldest first
+    uint64_t cycle = 0;
+    uint64_t sent_at = 0;
+    std::deque<uint64_t> unspent;
+
+    // Optional shared pool (owned by ThreadedFrontEnd) and this queue's lane in it
+    SharedCreditPool* pool = nullptr;
+    unsigned lane = 0;
 
     // Tracing support
     sc_trace_file* trace_file;
@@ -32,6 +102,10 @@ SC_MODULE(Threaded_Queue) {
     // Method to pop data from FIFO
     bool pop_data(RawTLP& pkt) ;
 
+    // Checkpoint of the state and driven outputs (see checkpoint.h)
+    void save_state(std::ostream& os) const;
+    void load_state(const CheckpointIn& ck);
+
     SC_CTOR(Threaded_Queue, unsigned int capacity) : fifo(capacity), capacity(capacity), trace_file(nullptr), enable_tracing(false) {
         SC_THREAD(main_thread);
         sensitive << clk.pos();
@@ -57,14 +131,30 @@ SC_MODULE(ThreadedFrontEnd) {
     sc_in<bool>         reset_n;
     sc_in<bool>         ingress_valid;
     sc_in<RawTLP>       ingress_tlp;
-    sc_out<sc_uint<3>>  credit_out;
+    sc_out<CreditBus>   credit_out;
 
     // Internal per-thread FIFOs
     Threaded_Queue* queues[3];
-    sc_signal<bool>      credit_signals[3];
+    sc_signal<unsigned>  credit_signals[3];
     sc_signal<RawTLP>    tlp_signals[3];
     sc_signal<bool>      valid_signals[3];
 
+    uint64_t pkts_routed = 0;
+    uint64_t pkts_popped = 0;
+
+    // Shared buffer pool mode (nullptr: one fixed FIFO per thread)
+    SharedCreditPool* pool = nullptr;
+    const unsigned queue_depth;    // capacity of each Threaded_Queue
+    unsigned max_occ = 0;          // peak packets held across all queues
+    unsigned max_outstanding = 0;  // peak credits advertised and not yet popped
+
+    // Endpoint SRAM entries this front end models
+    unsigned sram_entries() const { return pool ? pool->size() : 3 * queue_depth; }
+    void report();
+    // Zero the statistics reported above; the model state is left alone
+    // (scenario re-runs, see soft_reset in main.cpp)
+    void clear_stats();
+
     // Exposed helpers so outer modules can pull data deterministically
     bool has_data(int idx) const ;
 
@@ -73,16 +163,28 @@ SC_MODULE(ThreadedFrontEnd) {
     // Router thread: demux ingress packet by thread_id -> per-queue signals
     void input_router_thread();
 
-    // Combiner: OR-reduce per-queue credit pulses into a 3-bit bus
+    // Combiner: gather per-queue credit counts onto the credit bus
     void credit_combine_thread() ;
 
-    SC_CTOR(ThreadedFrontEnd, unsigned queue_capacity) {
+    // Includes the three queues
+    // Checkpoint of the state and driven outputs (see checkpoint.h)
+    void save_state(std::ostream& os) const;
+    void load_state(const CheckpointIn& ck);
+
+    // pool_min/pool_shared > 0 selects the shared pool; each queue can then
+    // hold up to pool_min + pool_shared packets.
+    SC_CTOR(ThreadedFrontEnd, unsigned queue_capacity, unsigned pool_min = 0, unsigned pool_shared = 0)
+        : queue_depth(pool_min + pool_shared > 0 ? pool_min + pool_shared : queue_capacity) {
+        if (pool_min + pool_shared > 0)
+            pool = new SharedCreditPool(pool_min, pool_shared);
         // Build child queue names without illegal '.' characters to avoid SystemC W506.
         std::string prefix(name());
         std::replace(prefix.begin(), prefix.end(), '.', '_');
         for (int i = 0; i < 3; ++i) {
             std::string qn = prefix + "_queue_" + std::to_string(i);
-            queues[i] = new Threaded_Queue(qn.c_str(), queue_capacity);
+            queues[i] = new Threaded_Queue(qn.c_str(), queue_depth);
+            queues[i]->pool = pool;
+            queues[i]->lane = i;
             queues[i]->clk(clk);
             queues[i]->reset_n(reset_n);
             queues[i]->raw_tlp_in(tlp_signals[i]);
@@ -100,6 +202,8 @@ SC_MODULE(ThreadedFrontEnd) {
 
 // -----------------------------------------------------------------------------
 // SimpleTxFIFO: single FIFO buffer with valid/ready handshake on egress.
+// With voq=true the same DEPTH entries are held as one queue per thread and
+// the next beat is chosen by a pluggable Arbiter instead of arrival order.
 // -----------------------------------------------------------------------------
 
 SC_MODULE(SimpleTxFIFO) {
@@ -113,22 +217,65 @@ SC_MODULE(SimpleTxFIFO) {
     sc_out<AxiWord>    egress_axi;
     sc_in<bool>        egress_ready;
 
-    sc_fifo<RawTLP> fifo;
+    TlpFifo fifo;
     unsigned int max_occ = 0;
 
+    // Per-thread virtual output queues (voq mode)
+    const unsigned DEPTH;
+    const bool VOQ;
+    std::deque<RawTLP> voq[3];
+    Arbiter* arb = nullptr;
+    std::deque<sc_time> enq_time[3];  // arrival times of queued packets, per thread
+
+    // Head-of-line statistics: per thread, packets queued behind the head and
+    // cycles spent waiting behind a head of another thread that did not move.
+    unsigned queued[3] = {0, 0, 0};
+    uint64_t hol_cycles[3] = {0, 0, 0};
+
+    // Per-thread occupancy and wait (enqueue -> handshake) statistics
+    uint64_t cycles = 0;
+    uint64_t occ_sum[3] = {0, 0, 0};
+    unsigned max_queued[3] = {0, 0, 0};
+    uint64_t sent[3] = {0, 0, 0};
+    double wait_sum_ns[3] = {0, 0, 0};
+    double wait_max_ns[3] = {0, 0, 0};
+    uint64_t dropped = 0;          // ingress packets lost to a full FIFO
+    uint64_t drive_cycle = 0;      // cycle the held beat was first driven
+    uint64_t hs_min = UINT64_MAX;  // fastest drive-to-handshake, in cycles
+
+    // Beat on the egress until its handshake
+    bool holding = false;
+    RawTLP held_pkt;
+    sc_time held_enq;
+
     // Tracing support
     sc_trace_file* trace_file;
     bool enable_tracing;
 
     void main_thread();
     void setup_tracing(bool enable = true);
-
-    SC_CTOR(SimpleTxFIFO, unsigned depth) : fifo(depth), trace_file(nullptr), enable_tracing(false) {
+    void report();
+    void clear_stats();
+    // Checkpoint of the state and driven outputs (see checkpoint.h)
+    void save_state(std::ostream& os) const;
+    void load_state(const CheckpointIn& ck);
+    // voq mode: replace the arbiter, restarting its state (takes ownership)
+    void set_arbiter(Arbiter* a) { delete arb; arb = a; }
+
+    SC_CTOR(SimpleTxFIFO, unsigned depth, bool voq = false, const std::string& arbiter = "rr",
+            const std::vector<unsigned>& weights = {})
+        : fifo(depth), DEPTH(depth), VOQ(voq), trace_file(nullptr), enable_tracing(false) {
+        if (VOQ) {
+            arb = make_arbiter(arbiter, 3, weights);
+            if (!arb)
+                SC_REPORT_FATAL(name(), ("unknown TX arbiter '" + arbiter + "'").c_str());
+        }
         SC_THREAD(main_thread);
         sensitive << clk.pos();
     }
 
     ~SimpleTxFIFO() {
+        delete arb;
         if (trace_file) {
             sc_close_vcd_trace_file(trace_file);
         }
@@ -151,8 +298,9 @@ SC_MODULE(SimpleRxFIFO) {
     sc_out<bool>       valid_out;
     sc_out<RawTLP>     tlp_out;
 
-    sc_fifo<RawTLP> fifo;
+    TlpFifo fifo;
     unsigned int max_occ = 0;
+    void clear_stats() { max_occ = 0; }
 
     // Tracing support
     sc_trace_file* trace_file;
@@ -160,6 +308,9 @@ SC_MODULE(SimpleRxFIFO) {
 
     void main_thread() ;
     void setup_tracing(bool enable = true);
+    // Checkpoint of the state and driven outputs (see checkpoint.h)
+    void save_state(std::ostream& os) const;
+    void load_state(const CheckpointIn& ck);
 
     SC_CTOR(SimpleRxFIFO, unsigned depth) : fifo(depth), trace_file(nullptr), enable_tracing(false) {
         SC_THREAD(main_thread);
@@ -173,14 +324,89 @@ SC_MODULE(SimpleRxFIFO) {
     }
 };
 
+// -----------------------------------------------------------------------------
+// CreditedRxFIFO: RX with its own credit domain (early credit release).  The
+// buffer is split into one PER_THREAD lane per thread and iRC_tx is granted
+// credits for these lanes directly, so a credit comes back as soon as a
+// packet leaves RX rather than when iEP pops it.  RX -> iEP is decoupled by
+// a local credit loop: a packet is forwarded only when its thread holds a
+// credit from iEP_after_RX.  Since upstream credits guarantee space,
+// ready_out stays high.
+// -----------------------------------------------------------------------------
+
+SC_MODULE(CreditedRxFIFO) {
+    sc_in<bool>        clk;
+    sc_in<bool>        reset_n;
+    // ingress from TX
+    sc_in<bool>        valid_in;
+    sc_in<AxiWord>     axi_in;
+    sc_out<bool>       ready_out;
+    // egress toward iEP_after_RX
+    sc_out<bool>       valid_out;
+    sc_out<RawTLP>     tlp_out;
+    sc_in<CreditBus>   ep_credit_in;    // local credits from iEP_after_RX
+    // credits for RX lanes toward iRC_tx (via CreditTx)
+    sc_out<CreditBus>  credit_out;
+
+    const unsigned PER_THREAD;
+    std::deque<RawTLP> lanes[3];
+    unsigned ep_credits[3] = {0, 0, 0};
+    unsigned rr = 0;
+    bool linked = false;
+
+    // Statistics
+    unsigned max_occ = 0;
+    uint64_t forwarded = 0;
+    uint64_t ep_blocked = 0;   // cycles with packets waiting but no iEP credit
+
+    unsigned occupancy() const { return lanes[0].size() + lanes[1].size() + lanes[2].size(); }
+
+    // Tracing support
+    sc_trace_file* trace_file;
+    bool enable_tracing;
+
+    void main_thread();
+    void setup_tracing(bool enable = true);
+    void report();
+    void clear_stats();
+
+    SC_CTOR(CreditedRxFIFO, unsigned per_thread)
+        : PER_THREAD(per_thread), trace_file(nullptr), enable_tracing(false) {
+        SC_THREAD(main_thread);
+        sensitive << clk.pos();
+    }
+
+    ~CreditedRxFIFO() {
+        if (trace_file) {
+            sc_close_vcd_trace_file(trace_file);
+        }
+    }
+};
+
 // -----------------------------------------------------------------------------
 // CreditTx: senses credit pulses near iEP and emits them as one AXI beat.
+// Fixed mode packs every window_size cycles, empty or not.  Adaptive mode
+// only sends beats that carry credits: immediately when a thread has
+// CREDIT_TX_URGENT credits waiting or the link has been quiet for
+// CREDIT_TX_IDLE_CYCLES, otherwise when the oldest held credit is 'window'
+// cycles old.  The window doubles after a backpressured beat and halves
+// after one that went straight through.
+// Reverse data from the iEP side arrives on rev_valid_in/rev_tlp_in (one
+// packet held here); every data beat takes the held credits with it and
+// credit-only beats are sent only while no reverse data is waiting.
 // -----------------------------------------------------------------------------
 
+static_assert(RX_EARLY_PER_THREAD <= CREDIT_CNT_MAX,
+              "credit bus count field too narrow for the RX link-up advertisement");
+
 SC_MODULE(CreditTx){
     sc_in<bool>        clk;
     sc_in<bool>        reset_n;
-    sc_in<sc_uint<3>>  credit_in;   // pulses from iEP queues
+    sc_in<CreditBus>   credit_in;   // credit counts from iEP queues
+    // reverse data from the iEP side (valid/ready)
+    sc_in<bool>        rev_valid_in;
+    sc_in<RawTLP>      rev_tlp_in;
+    sc_out<bool>       rev_ready_out;
     // AXI Stream out
     sc_out<bool>       valid_out;
     sc_out<AxiWord>    axi_out;
@@ -190,7 +416,28 @@ SC_MODULE(CreditTx){
     unsigned ctr = 0;
     bool sending = false;
     AxiWord pending;
-    const unsigned window_size;
+    unsigned window_size;         // may change between cycles (scenario phases)
+    const bool adaptive;
+    unsigned window;              // current adaptive window
+    unsigned idle = 0;            // cycles since the last beat was accepted
+    unsigned stalled = 0;         // cycles the pending beat waited for ready
+
+    // Statistics
+    uint64_t beats = 0;
+    uint64_t empty_beats = 0;
+    uint64_t credits_sent = 0;    // in credit-only beats
+    uint64_t hold_sum = 0;        // cycles the oldest credit waited per beat
+    uint64_t stall_sum = 0;
+    uint64_t urgent_beats = 0;
+    uint64_t idle_beats = 0;
+    uint64_t window_sum = 0;
+
+    // Reverse data channel (credit piggybacking)
+    bool     rev_held = false;    // rev_pkt waits for the link
+    RawTLP   rev_pkt;
+    uint64_t rev_beats = 0;
+    uint64_t piggy_beats = 0;     // data beats that also carried credits
+    uint64_t piggy_credits = 0;
 
     // Tracing support
     sc_trace_file* trace_file;
@@ -198,8 +445,15 @@ SC_MODULE(CreditTx){
 
     void main_thread();
     void setup_tracing(bool enable = true);
-    
-    SC_CTOR(CreditTx, unsigned window) : window_size(window), trace_file(nullptr), enable_tracing(false) {
+    void report();
+    void clear_stats();
+    // Checkpoint of the state and driven outputs (see checkpoint.h)
+    void save_state(std::ostream& os) const;
+    void load_state(const CheckpointIn& ck);
+
+    SC_CTOR(CreditTx, unsigned window, bool adaptive = false)
+        : window_size(window), adaptive(adaptive), window(CREDIT_TX_MIN_WINDOW),
+          trace_file(nullptr), enable_tracing(false) {
         SC_THREAD(main_thread);
         sensitive<<clk.pos();
     }
@@ -212,7 +466,13 @@ SC_MODULE(CreditTx){
 };
 
 // -----------------------------------------------------------------------------
-// CreditRx: converts AXI credit packet back into per-thread pulses for iRC_tx
+// CreditRx: converts AXI credit packet back into per-thread pulses for iRC_tx.
+// In count mode the whole beat is forwarded as counts in one cycle.  Pulse
+// mode unrolls it one credit per cycle, either merging new beats into the
+// running counters (merge) or refusing them until the counters drain.  Only
+// the blocking pulse mode ever backpressures the CNOC.  Reverse data beats
+// are forwarded to the RC on rev_valid_out/rev_tlp_out and their piggybacked
+// credits are returned like those of a credit beat.
 // -----------------------------------------------------------------------------
 
 SC_MODULE(CreditRx){
@@ -223,9 +483,22 @@ SC_MODULE(CreditRx){
     sc_in<AxiWord>     axi_in;
     sc_out<bool>       ready_out;
     // Credit pulses toward RC
-    sc_out<sc_uint<3>> credit_out;
+    sc_out<CreditBus>  credit_out;
+    // Reverse data toward RC (raw valid, one cycle per packet)
+    sc_out<bool>       rev_valid_out;
+    sc_out<RawTLP>     rev_tlp_out;
 
     sc_uint<16> emit_cnt[3] = {0,0,0};
+    const bool count_mode;
+    const bool merge;
+
+    // Statistics
+    uint64_t cycles = 0;
+    uint64_t beats = 0;
+    uint64_t credits_out = 0;
+    uint64_t stall_cycles = 0;    // valid beat waiting on our ready
+    unsigned max_backlog = 0;
+    uint64_t rev_data = 0;        // reverse data beats forwarded to RC
 
     // Tracing support
     sc_trace_file* trace_file;
@@ -233,8 +506,14 @@ SC_MODULE(CreditRx){
 
     void main_thread();
     void setup_tracing(bool enable = true);
+    void report();
+    void clear_stats();
+    // Checkpoint of the state and driven outputs (see checkpoint.h)
+    void save_state(std::ostream& os) const;
+    void load_state(const CheckpointIn& ck);
 
-    SC_CTOR(CreditRx) : trace_file(nullptr), enable_tracing(false) {
+    SC_CTOR(CreditRx, bool count_mode = false, bool merge = false)
+        : count_mode(count_mode), merge(merge), trace_file(nullptr), enable_tracing(false) {
         SC_THREAD(main_thread);
         sensitive<<clk.pos();
     }
@@ -254,15 +533,72 @@ SC_MODULE(iRC) {
     sc_in<bool>         clk;
     sc_in<bool>         reset_n;
     
-    sc_in<sc_uint<3>>   credit_in;  // 3-bit credit bus for 3 threads
+    sc_in<CreditBus>    credit_in;  // per-thread credit counts
     sc_out<bool>        raw_valid;
     sc_out<RawTLP>      raw_tlp;
+    // reverse data from the EP side (see CreditRx)
+    sc_in<bool>         rev_valid;
+    sc_in<RawTLP>       rev_tlp;
 
     // Internal state
     int packet_seq;
     int credit_counter[3];  // Array of credit counters for each thread
     sc_event credit_event;  // Event to signal when any credit is received
 
+    // Credit-loop RTT: once the initial advertisement (THREAD_Q_DEPTH per
+    // thread) has arrived, each credit is matched to the oldest send of its thread.
+    std::deque<sc_time> outstanding[3];
+    unsigned initial_left[3];
+    uint64_t pkts_sent = 0;
+    uint64_t rtt_samples = 0;
+    double   rtt_sum_ns = 0.0;
+    double   rtt_max_ns = 0.0;
+    double   rtt_min_ns = -1.0;    // unloaded loop latency (-1: no sample yet)
+
+    double avg_rtt_ns() const { return rtt_samples ? rtt_sum_ns / rtt_samples : 0.0; }
+
+    // Startup after each reset: time from link-up to the first send and to
+    // the arrival of the whole initial advertisement (full-rate window).
+    bool     in_reset = true;
+    unsigned init_window = THREAD_Q_DEPTH;   // credits per thread advertised at link-up
+    sc_time  link_up;
+    double   first_send_ns = -1.0;
+    double   full_window_ns = -1.0;
+
+    // Thread arbitration, owned per instance.  credit_time holds the arrival
+    // time of every unused credit so age-based policies can pick the thread
+    // holding the oldest one.
+    Arbiter* arb = nullptr;
+    std::deque<sc_time> credit_time[3];
+    uint64_t sent_per_thread[3] = {0, 0, 0};
+
+    // Open-loop traffic: with a model set, packets arrive into per-thread
+    // source queues (arrival times, at most TRAFFIC_SRC_Q_DEPTH each; a trace
+    // is held back rather than dropped) and a thread is eligible only when it
+    // has both a queued packet and a credit.
+    // Without one iRC sends whenever it holds a credit (saturation).
+    LatencyProbe* probe = nullptr;   // not owned
+    TrafficModel* gen = nullptr;
+    bool     traffic_on = true;    // false: no new packets (queued arrivals still go)
+    std::deque<sc_time> src_q[3];
+    uint64_t offered[3] = {0, 0, 0};
+    uint64_t src_dropped = 0;
+    size_t   src_q_max = 0;
+    double   src_wait_sum_ns = 0.0;
+    double   src_wait_max_ns = 0.0;
+    double   src_wait_last_ns = 0.0;
+
+    // Credit starvation while traffic_on: cycles a thread had something to
+    // send (always, when saturated) but no credit.  window_cycles counts the
+    // cycles with traffic on.
+    uint64_t starved[3] = {0, 0, 0};
+    uint64_t window_cycles = 0;
+
+    // Reverse data received; rev_probe (shared with the sending iEP) gives
+    // its creation-to-arrival latency
+    LatencyProbe* rev_probe = nullptr;   // not owned
+    uint64_t rev_received = 0;
+
     // Tracing support
     sc_trace_file* trace_file;
     bool enable_tracing;
@@ -273,8 +609,25 @@ SC_MODULE(iRC) {
     // Thread for sending TLPs
     void sender_thread() ;
     void setup_tracing(bool enable = true);
+    void report();
+    void clear_stats();
+
+    // Checkpoint of the state and driven outputs (see checkpoint.h).  The
+    // traffic_on gate is set by the scenario phases and is not saved.
+    void save_state(std::ostream& os) const;
+    void load_state(const CheckpointIn& ck);
+
+    // Replace the arbitration policy; takes ownership.  Safe between cycles.
+    void set_arbiter(Arbiter* a) { delete arb; arb = a; }
+    // Replace the traffic model (nullptr: saturation); takes ownership.
+    void set_traffic(TrafficModel* t) { delete gen; gen = t; }
     
-    SC_CTOR(iRC) : trace_file(nullptr), enable_tracing(false) {
+    SC_CTOR(iRC, const std::string& arbiter = "rr", const std::vector<unsigned>& weights = {})
+        : trace_file(nullptr), enable_tracing(false) {
+        arb = make_arbiter(arbiter, 3, weights);
+        if (!arb)
+            SC_REPORT_FATAL(name(), ("unknown iRC arbiter '" + arbiter + "'").c_str());
+
         // Register the threads
         SC_THREAD(credit_monitor_thread);
         sensitive << clk.pos() << credit_in;;  // Only sensitive to clock edges
@@ -284,6 +637,8 @@ SC_MODULE(iRC) {
     }
 
     ~iRC() {
+        delete arb;
+        delete gen;
         if (trace_file) {
             sc_close_vcd_trace_file(trace_file);
         }
@@ -296,10 +651,34 @@ SC_MODULE(iEP) {
     sc_in<bool>         reset_n;
     sc_in<bool>         raw_valid;
     sc_in<RawTLP>       raw_tlp;
-    sc_out<sc_uint<3>>  credit_out;
+    sc_out<CreditBus>   credit_out;
+    // reverse data toward the RC (valid/ready)
+    sc_out<bool>        rev_valid;
+    sc_out<RawTLP>      rev_tlp;
+    sc_in<bool>         rev_ready;
 
     ThreadedFrontEnd* threaded_queues;
 
+    // Consumer service model (nullptr: one pop per queue per cycle).
+    // held_cycles counts cycles a queue had data but no service grant, i.e.
+    // the consumer, not the link, was holding the credits back.
+    DrainModel* drain = nullptr;
+    LatencyProbe* probe = nullptr;   // not owned
+    uint64_t popped[3] = {0, 0, 0};
+    uint64_t held_cycles[3] = {0, 0, 0};
+    uint64_t active_cycles = 0;
+
+    // Reverse traffic: one packet per 100/rev_pct cycles on average, queued
+    // here until the link takes it (0: none)
+    unsigned rev_pct = 0;
+    unsigned rev_acc = 0;            // arrival accumulator, one packet per 100
+    unsigned rev_seq = 1;
+    std::deque<RawTLP> rev_q;
+    LatencyProbe* rev_probe = nullptr;   // not owned
+    uint64_t rev_offered = 0;
+    uint64_t rev_sent = 0;
+    unsigned max_rev_backlog = 0;
+
     // Tracing support
     sc_trace_file* trace_file;
     bool enable_tracing;
@@ -308,10 +687,23 @@ SC_MODULE(iEP) {
     void process_popped_data(const RawTLP& pkt, int queue_id) ;
 
     void popper_thread() ;
+    void reverse_thread();
     void setup_tracing(bool enable = true);
+    void report();
+    void clear_stats();
 
-    SC_CTOR(iEP, unsigned queue_capacity) : trace_file(nullptr), enable_tracing(false) {
-        threaded_queues = new ThreadedFrontEnd((std::string(name()) + "_front").c_str(), queue_capacity);
+    // Includes the front end and its queues
+    // Checkpoint of the state and driven outputs (see checkpoint.h)
+    void save_state(std::ostream& os) const;
+    void load_state(const CheckpointIn& ck);
+
+    // Replace the drain model; takes ownership.  Safe between cycles.
+    void set_drain(DrainModel* d) { delete drain; drain = d; }
+
+    SC_CTOR(iEP, unsigned queue_capacity, unsigned pool_min = 0, unsigned pool_shared = 0)
+        : trace_file(nullptr), enable_tracing(false) {
+        threaded_queues = new ThreadedFrontEnd((std::string(name()) + "_front").c_str(), queue_capacity,
+                                               pool_min, pool_shared);
         threaded_queues->clk(clk);
         threaded_queues->reset_n(reset_n);
         threaded_queues->ingress_valid(raw_valid);
@@ -320,15 +712,56 @@ SC_MODULE(iEP) {
 
         SC_THREAD(popper_thread);
         sensitive << clk.pos() << reset_n;
+
+        SC_THREAD(reverse_thread);
+        sensitive << clk.pos();
     }
 
     ~iEP() {
+        delete drain;
         if (trace_file) {
             sc_close_vcd_trace_file(trace_file);
         }
     }
 };
 
+// -----------------------------------------------------------------------------
+// NocLink: fixed-latency pipe with a periodic stall pattern.  This is the
+// latency/back-pressure model behind AxiNoC, kept free of ports so the mesh
+// fabric can instantiate one per router-to-router link.
+// -----------------------------------------------------------------------------
+
+struct NocLink {
+    const unsigned PIPE_LAT; // latency cycles
+    const unsigned NOC_PATTERN_LEN;
+    unsigned NOC_STALL_PCT;  // may change between cycles (scenario phases)
+    AxiWord* pipe;
+    bool* pipe_valid;
+    unsigned delta_cycle_ctr = 0;
+    bool stall_active_sig = false;
+    unsigned pattern_ctr = 0;
+
+    NocLink(unsigned latency, unsigned pattern_len, unsigned stall_pct);
+    ~NocLink();
+    NocLink(const NocLink&) = delete;
+    NocLink& operator=(const NocLink&) = delete;
+
+    void reset();
+    // Advance the stall pattern by one cycle.
+    void advance();
+    // True when pipe[0] is free and the link is not stalled next cycle.
+    bool ready() const { return !pipe_valid[0] && !stall_active_sig; }
+    void push(const AxiWord& w) { pipe[0] = w; pipe_valid[0] = true; }
+    bool out_valid() const { return pipe_valid[PIPE_LAT - 1]; }
+    const AxiWord& out() const { return pipe[PIPE_LAT - 1]; }
+    void pop() { pipe_valid[PIPE_LAT - 1] = false; }
+    void shift();
+
+    // Pipe contents and stall pattern position (not the stall percentage)
+    void save(std::ostream& os) const;
+    void load(std::istream& is);
+};
+
 // -----------------------------------------------------------------------------
 // AxiNoC: simple elastic buffer that injects random back-pressure (ready=0)
 // cycles to emulate a network. Parameter MAX_STALL controls worst-case stall
@@ -348,15 +781,8 @@ SC_MODULE(AxiNoC) {
     sc_in<bool>        ready_in;
 
     // Internal state
-    const unsigned PIPE_LAT; // latency cycles
-    AxiWord* pipe;
-    bool* pipe_valid;
-    unsigned delta_cycle_ctr = 0;
-    bool stall_active_sig = false;
-    unsigned pattern_ctr = 0;
+    NocLink link;
     bool is_main_noc;
-    const unsigned NOC_PATTERN_LEN;
-    const unsigned NOC_STALL_PCT;
 
     // Tracing support
     sc_trace_file* trace_file;
@@ -364,22 +790,327 @@ SC_MODULE(AxiNoC) {
 
     void main_thread();
     void setup_tracing(bool enable = true);
+    // Checkpoint of the state and driven outputs (see checkpoint.h)
+    void save_state(std::ostream& os) const;
+    void load_state(const CheckpointIn& ck);
 
     SC_CTOR(AxiNoC, unsigned latency, unsigned pattern_len = 100, unsigned stall_pct = 15) 
-        : PIPE_LAT(latency), is_main_noc(std::string(name()) == "AXI_NOC"),
-          NOC_PATTERN_LEN(pattern_len), NOC_STALL_PCT(stall_pct), trace_file(nullptr), enable_tracing(false) {
-        pipe = new AxiWord[PIPE_LAT];
-        pipe_valid = new bool[PIPE_LAT];
-        for(unsigned i = 0; i < PIPE_LAT; i++) {
-            pipe_valid[i] = false;
-        }
+        : link(latency, pattern_len, stall_pct), is_main_noc(std::string(name()) == "AXI_NOC"),
+          trace_file(nullptr), enable_tracing(false) {
         SC_THREAD(main_thread);
         sensitive << clk.pos();
     }
 
     ~AxiNoC() {
-        delete[] pipe;
-        delete[] pipe_valid;
+        if (trace_file) {
+            sc_close_vcd_trace_file(trace_file);
+        }
+    }
+};
+
+// -----------------------------------------------------------------------------
+// CreditedAxiNoC: same endpoints as AxiNoC, but the PIPE_LAT cycles of wire are
+// split into HOPS hops with credit-based flow control.  Each hop ends in a
+// HOP_BUF-deep buffer; the upstream stage holds one credit per free slot and
+// a credit returns CREDIT_LAT cycles after its slot is freed.  Every hop
+// follows the stall pattern at its own phase.  The ingress buffer keeps the
+// registered valid/ready handshake toward TX and the last hop's buffer drives
+// RX the same way.
+// -----------------------------------------------------------------------------
+
+struct CreditedHop {
+    std::deque<std::pair<uint64_t, AxiWord>> wire;   // (arrival cycle, beat)
+    std::deque<AxiWord> buf;                         // buffer at the far end
+    std::deque<uint64_t> credit_wire;                // credit arrival cycles
+    unsigned credits = 0;                            // held by the upstream stage
+
+    // Statistics
+    uint64_t sent = 0;
+    uint64_t starved = 0;    // cycles with a beat waiting but no credit
+    unsigned max_buf = 0;
+};
+
+SC_MODULE(CreditedAxiNoC) {
+    sc_in<bool>        clk;
+    sc_in<bool>        reset_n;
+    // upstream (TX) side
+    sc_in<bool>        valid_in;
+    sc_in<AxiWord>     axi_in;
+    sc_out<bool>       ready_out;
+    // downstream (RX) side
+    sc_out<bool>       valid_out;
+    sc_out<AxiWord>    axi_out;
+    sc_in<bool>        ready_in;
+
+    const unsigned HOPS;
+    const unsigned HOP_LAT;
+    const unsigned HOP_BUF;
+    const unsigned CREDIT_LAT;
+    const unsigned INGRESS_DEPTH;
+    const unsigned NOC_PATTERN_LEN;
+    unsigned NOC_STALL_PCT;   // may change between cycles (scenario phases)
+
+    std::deque<AxiWord> ingress;
+    std::vector<CreditedHop> hops;
+    uint64_t cycle = 0;
+    uint64_t delivered = 0;
+
+    // Tracing support
+    sc_trace_file* trace_file;
+    bool enable_tracing;
+
+    void main_thread();
+    void setup_tracing(bool enable = true);
+    void report();
+    void clear_stats();
+    void reset_hops();
+    unsigned buffer_entries() const { return INGRESS_DEPTH + HOPS * HOP_BUF; }
+
+    SC_CTOR(CreditedAxiNoC, unsigned latency, unsigned hops, unsigned hop_buf, unsigned credit_lat,
+            unsigned pattern_len = 100, unsigned stall_pct = 15)
+        : HOPS(hops), HOP_LAT(std::max(1u, latency / hops)), HOP_BUF(hop_buf),
+          CREDIT_LAT(credit_lat), INGRESS_DEPTH(2), NOC_PATTERN_LEN(pattern_len),
+          NOC_STALL_PCT(stall_pct), hops(hops), trace_file(nullptr), enable_tracing(false) {
+        reset_hops();
+        SC_THREAD(main_thread);
+        sensitive << clk.pos();
+    }
+
+    ~CreditedAxiNoC() {
+        if (trace_file) {
+            sc_close_vcd_trace_file(trace_file);
+        }
+    }
+};
+
+// -----------------------------------------------------------------------------
+// Virtual-channel data path.  VcTxFIFO, VcAxiNoC and VcRxFIFO keep one lane per
+// thread and replace the single ready with a per-lane ready vector (bit i =
+// lane i can take a beat next cycle).  Each stage round-robins over the lanes
+// whose downstream ready is high, so a blocked thread never holds up another.
+// -----------------------------------------------------------------------------
+
+SC_MODULE(VcTxFIFO) {
+    sc_in<bool>        clk;
+    sc_in<bool>        reset_n;
+    // ingress from iRC_tx (raw_valid/raw_tlp)
+    sc_in<bool>        ingress_valid;
+    sc_in<RawTLP>      ingress_tlp;
+    // egress toward the NoC (valid + per-lane ready)
+    sc_out<bool>       egress_valid;
+    sc_out<AxiWord>    egress_axi;
+    sc_in<sc_uint<3>>  egress_ready;
+
+    const unsigned LANE_DEPTH;
+    std::deque<RawTLP> lanes[3];
+    unsigned rr = 0;
+    int driven_lane = -1;             // lane of the beat driven last cycle
+    unsigned int max_occ = 0;
+    uint64_t dropped = 0;             // ingress packets lost to a full lane
+
+    // Head-of-line statistics, as in SimpleTxFIFO: cycles a lane had packets
+    // while the beat of another lane was driven and not taken, and of those
+    // the cycles its own lane was ready (it could have gone instead)
+    uint64_t hol_cycles[3] = {0, 0, 0};
+    uint64_t hol_ready_cycles[3] = {0, 0, 0};
+
+    // Tracing support
+    sc_trace_file* trace_file;
+    bool enable_tracing;
+
+    void main_thread();
+    void setup_tracing(bool enable = true);
+    void report();
+    void clear_stats();
+
+    SC_CTOR(VcTxFIFO, unsigned lane_depth) : LANE_DEPTH(lane_depth), trace_file(nullptr), enable_tracing(false) {
+        SC_THREAD(main_thread);
+        sensitive << clk.pos();
+    }
+
+    ~VcTxFIFO() {
+        if (trace_file) {
+            sc_close_vcd_trace_file(trace_file);
+        }
+    }
+};
+
+// Shared physical pipe (NocLink without stalls) with per-lane congestion: each
+// lane follows the AxiNoC stall pattern at its own phase, and per-lane egress
+// buffers are reserved at ingress (lane credits) so a full lane can never
+// block the pipe.
+SC_MODULE(VcAxiNoC) {
+    sc_in<bool>        clk;
+    sc_in<bool>        reset_n;
+    // upstream (TX) side
+    sc_in<bool>        valid_in;
+    sc_in<AxiWord>     axi_in;
+    sc_out<sc_uint<3>> ready_out;
+    // downstream (RX) side
+    sc_out<bool>       valid_out;
+    sc_out<AxiWord>    axi_out;
+    sc_in<sc_uint<3>>  ready_in;
+
+    NocLink link;
+    const unsigned LANE_DEPTH;
+    unsigned NOC_STALL_PCT;   // may change between cycles (scenario phases)
+    std::deque<AxiWord> egress[3];
+    unsigned lane_credits[3];
+    unsigned rr = 0;
+    int driven_lane = -1;
+    sc_uint<3> lane_stall = 0;        // per-lane stall state for the next cycle
+    bool is_main_noc;
+
+    // Tracing support
+    sc_trace_file* trace_file;
+    bool enable_tracing;
+
+    void reset_lanes();
+    void main_thread();
+    void setup_tracing(bool enable = true);
+
+    SC_CTOR(VcAxiNoC, unsigned latency, unsigned lane_depth, unsigned pattern_len = 100, unsigned stall_pct = 15)
+        : link(latency, pattern_len, 0), LANE_DEPTH(lane_depth), NOC_STALL_PCT(stall_pct),
+          is_main_noc(std::string(name()) == "AXI_NOC"), trace_file(nullptr), enable_tracing(false) {
+        reset_lanes();
+        SC_THREAD(main_thread);
+        sensitive << clk.pos();
+    }
+
+    ~VcAxiNoC() {
+        if (trace_file) {
+            sc_close_vcd_trace_file(trace_file);
+        }
+    }
+};
+
+SC_MODULE(VcRxFIFO) {
+    sc_in<bool>        clk;
+    sc_in<bool>        reset_n;
+    // ingress from the NoC (valid + per-lane ready)
+    sc_in<bool>        valid_in;
+    sc_in<AxiWord>     axi_in;
+    sc_out<sc_uint<3>> ready_out;
+    // egress toward iEP_after_RX
+    sc_out<bool>       valid_out;
+    sc_out<RawTLP>     tlp_out;
+
+    const unsigned LANE_DEPTH;
+    std::deque<RawTLP> lanes[3];
+    unsigned rr = 0;
+    unsigned int max_occ = 0;
+    void clear_stats() { max_occ = 0; }
+
+    // Tracing support
+    sc_trace_file* trace_file;
+    bool enable_tracing;
+
+    void main_thread();
+    void setup_tracing(bool enable = true);
+
+    SC_CTOR(VcRxFIFO, unsigned lane_depth) : LANE_DEPTH(lane_depth), trace_file(nullptr), enable_tracing(false) {
+        SC_THREAD(main_thread);
+        sensitive << clk.pos();
+    }
+
+    ~VcRxFIFO() {
+        if (trace_file) {
+            sc_close_vcd_trace_file(trace_file);
+        }
+    }
+};
+
+// -----------------------------------------------------------------------------
+// MeshNoC: DIM_X x DIM_Y mesh (or torus) of 5-port routers with XY routing,
+// per-port input buffers and round-robin output arbitration.  Every
+// router-to-router hop is a NocLink, so hop latency and stall behaviour match
+// AxiNoC.  Each node exposes one AxiNoC-style ingress and egress port; beats
+// entering at a node are stamped with that node's configured destination.
+// -----------------------------------------------------------------------------
+
+SC_MODULE(MeshNoC) {
+    enum Port { PORT_LOCAL = 0, PORT_NORTH, PORT_EAST, PORT_SOUTH, PORT_WEST, NUM_PORTS };
+
+    sc_in<bool>        clk;
+    sc_in<bool>        reset_n;
+    // per-node local ports, indexed by node id (y * DIM_X + x)
+    sc_in<bool>*       inj_valid;
+    sc_in<AxiWord>*    inj_axi;
+    sc_out<bool>*      inj_ready;
+    sc_out<bool>*      ej_valid;
+    sc_out<AxiWord>*   ej_axi;
+    sc_in<bool>*       ej_ready;
+
+    const unsigned DIM_X;
+    const unsigned DIM_Y;
+    const bool     TORUS;
+    const unsigned BUF_DEPTH;
+
+    struct Router {
+        std::deque<AxiWord> in_buf[NUM_PORTS];
+        unsigned rr[NUM_PORTS] = {0, 0, 0, 0, 0}; // per-output round-robin pointer
+    };
+    std::vector<Router>   routers;
+    std::vector<NocLink*> links;      // [node * 4 + dir - 1], nullptr at mesh edges
+    std::vector<NocLink*> inj_links;  // network-interface pipes into each router
+    std::vector<NocLink*> ej_links;   // network-interface pipes out of each router
+    std::vector<int>      dest_of;    // destination stamped on beats injected at a node
+
+    // Statistics
+    std::vector<uint64_t> injected;
+    std::vector<uint64_t> ejected;
+    uint64_t link_flits = 0;      // router-to-router traversals
+    uint64_t arb_losses = 0;      // head flits that lost output arbitration
+    uint64_t link_blocked = 0;    // head flits that won but found the link stalled/full
+    unsigned max_buf_occ = 0;
+
+    // Tracing support
+    sc_trace_file* trace_file;
+    bool enable_tracing;
+
+    unsigned num_nodes() const { return DIM_X * DIM_Y; }
+    unsigned node_id(unsigned x, unsigned y) const { return y * DIM_X + x; }
+    void set_route(unsigned src, unsigned dst);
+    unsigned hops(unsigned src, unsigned dst) const;
+    unsigned route(unsigned node, unsigned dst) const;
+    int neighbour(unsigned node, unsigned dir) const;
+
+    void main_thread();
+    void report();
+    void clear_stats();
+    void setup_tracing(bool enable = true);
+
+    SC_CTOR(MeshNoC, unsigned dim_x, unsigned dim_y, bool torus, unsigned link_latency,
+            unsigned pattern_len, unsigned stall_pct, unsigned buf_depth)
+        : DIM_X(dim_x), DIM_Y(dim_y), TORUS(torus), BUF_DEPTH(buf_depth),
+          trace_file(nullptr), enable_tracing(false) {
+        const unsigned n = num_nodes();
+        inj_valid = new sc_in<bool>[n];
+        inj_axi   = new sc_in<AxiWord>[n];
+        inj_ready = new sc_out<bool>[n];
+        ej_valid  = new sc_out<bool>[n];
+        ej_axi    = new sc_out<AxiWord>[n];
+        ej_ready  = new sc_in<bool>[n];
+        routers.resize(n);
+        dest_of.assign(n, -1);
+        injected.assign(n, 0);
+        ejected.assign(n, 0);
+        for (unsigned node = 0; node < n; ++node) {
+            for (unsigned dir = PORT_NORTH; dir <= PORT_WEST; ++dir)
+                links.push_back(neighbour(node, dir) >= 0
+                                    ? new NocLink(link_latency, pattern_len, stall_pct)
+                                    : nullptr);
+            inj_links.push_back(new NocLink(1, pattern_len, 0));
+            ej_links.push_back(new NocLink(1, pattern_len, 0));
+        }
+        SC_THREAD(main_thread);
+        sensitive << clk.pos();
+    }
+
+    ~MeshNoC() {
+        for (auto* l : links) delete l;
+        for (auto* l : inj_links) delete l;
+        for (auto* l : ej_links) delete l;
         if (trace_file) {
             sc_close_vcd_trace_file(trace_file);
         }
@@ -393,8 +1124,8 @@ SC_MODULE(AxiNoC) {
 
 SC_MODULE(CreditDutyMon){
     sc_in<bool>        clk;
-    sc_in<sc_uint<3>>  bus_direct;
-    sc_in<sc_uint<3>>  bus_hybrid;
+    sc_in<CreditBus>   bus_direct;
+    sc_in<CreditBus>   bus_hybrid;
 
     sc_uint<64> total      = 0;
     sc_uint<64> hi_direct  = 0;
@@ -406,7 +1137,10 @@ SC_MODULE(CreditDutyMon){
 
     void sample();
     void report();
+    void clear_stats();
     void setup_tracing(bool enable = true);
+    void save_state(std::ostream& os) const;
+    void load_state(const CheckpointIn& ck);
 
     SC_CTOR(CreditDutyMon) : trace_file(nullptr), enable_tracing(false) {
         SC_METHOD(sample);
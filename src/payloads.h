@@ -1,6 +1,8 @@
 #ifndef PAYLOADS_H
 #define PAYLOADS_H
 
+#include <deque>
+
 // Simple Raw TLP packet
 struct RawTLP {
     sc_uint<32>   seq_num;    // Unique sequence number
@@ -24,6 +26,32 @@ inline void sc_trace(sc_trace_file* tf, const RawTLP& tlp, const std::string& na
     sc_trace(tf, tlp.thread_id, name + ".thread_id");
 }
 
+// sc_fifo of TLPs that also keeps a copy of what it stores, oldest first, so
+// a checkpoint can list the packets without consuming them.  Modules use it
+// through write/nb_write/nb_read only.
+class TlpFifo : public sc_fifo<RawTLP> {
+public:
+    explicit TlpFifo(int size) : sc_fifo<RawTLP>(size) {}
+
+    void write(const RawTLP& p) { sc_fifo<RawTLP>::write(p); stored.push_back(p); }
+    bool nb_write(const RawTLP& p) {
+        if (!sc_fifo<RawTLP>::nb_write(p))
+            return false;
+        stored.push_back(p);
+        return true;
+    }
+    bool nb_read(RawTLP& p) {
+        if (!sc_fifo<RawTLP>::nb_read(p))
+            return false;
+        stored.pop_front();
+        return true;
+    }
+    const std::deque<RawTLP>& contents() const { return stored; }
+
+private:
+    std::deque<RawTLP> stored;
+};
+
 // ---------------- AXI Stream word used only between TX and RX ----------------
 struct AxiWord {
     sc_uint<64> data{0};
@@ -59,6 +87,61 @@ inline RawTLP axi_to_tlp(const AxiWord& w){
     return p;
 }
 
+// Threads are numbered 1..3; per-thread lanes/queues are indexed 0..2.
+inline unsigned thread_lane(const RawTLP& p){
+    return (p.thread_id.to_uint() + 2) % 3;
+}
+
+// Credit return bus: one CREDIT_CNT_BITS count field per thread lane.  In
+// pulse mode every field is 0 or 1; in count mode a whole credit beat can be
+// handed to iRC in one cycle.
+constexpr unsigned CREDIT_CNT_BITS = 6;
+constexpr unsigned CREDIT_CNT_MAX  = (1u << CREDIT_CNT_BITS) - 1;
+typedef sc_uint<3 * CREDIT_CNT_BITS> CreditBus;
+
+inline unsigned credit_count(const CreditBus& b, unsigned lane){
+    return b.range(lane * CREDIT_CNT_BITS + CREDIT_CNT_BITS - 1, lane * CREDIT_CNT_BITS).to_uint();
+}
+
+inline void credit_set(CreditBus& b, unsigned lane, unsigned n){
+    b.range(lane * CREDIT_CNT_BITS + CREDIT_CNT_BITS - 1, lane * CREDIT_CNT_BITS) = n;
+}
+
+// Reverse-direction data beat (EP -> RC) with credits piggybacked in the
+// bits a TLP leaves free: bits 34.. hold one CREDIT_CNT_BITS count per
+// thread and bit 55 flags data.  Credit-only beats keep the credits_to_axi
+// layout (bits 47:0), so bit 55 is always clear on them.
+constexpr unsigned PIGGY_LSB     = 34;
+constexpr unsigned REV_DATA_BIT  = 55;
+static_assert(PIGGY_LSB + 3 * CREDIT_CNT_BITS <= REV_DATA_BIT, "piggybacked credits overlap the data flag");
+
+inline AxiWord rev_data_to_axi(const RawTLP& p, unsigned c0, unsigned c1, unsigned c2){
+    AxiWord w = tlp_to_axi(p);
+    w.data[REV_DATA_BIT] = 1;
+    const unsigned c[3] = {c0, c1, c2};
+    for (unsigned i = 0; i < 3; ++i)
+        w.data.range(PIGGY_LSB + (i + 1) * CREDIT_CNT_BITS - 1, PIGGY_LSB + i * CREDIT_CNT_BITS) = c[i];
+    return w;
+}
+
+inline bool axi_is_rev_data(const AxiWord& w){
+    return w.data[REV_DATA_BIT];
+}
+
+inline unsigned axi_piggy_credits(const AxiWord& w, unsigned lane){
+    return w.data.range(PIGGY_LSB + (lane + 1) * CREDIT_CNT_BITS - 1, PIGGY_LSB + lane * CREDIT_CNT_BITS).to_uint();
+}
+
+// Mesh routing: the destination node rides in the top byte of a beat, which
+// neither TLP nor credit packing uses.
+inline void axi_set_dest(AxiWord& w, unsigned node){
+    w.data.range(63,56) = node;
+}
+
+inline unsigned axi_get_dest(const AxiWord& w){
+    return w.data.range(63,56).to_uint();
+}
+
 // -----------------------------------------------------------------------------
 // Helper for packing three 10-bit credit counters into a single AXI beat
 
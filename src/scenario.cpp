@@ -0,0 +1,160 @@
+#include "scenario.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+static const char* const SCENARIO_KEYS[] = {
+    "load", "traffic", "pop", "drain", "drain-rate", "stall", "credit-stall", "window",
+};
+
+// 'rerun' also allows the keys that only take effect from a reset
+static bool known_key(const std::string& key, bool rerun = false)
+{
+    for (const char* k : SCENARIO_KEYS)
+        if (key == k)
+            return true;
+    return rerun && key == "seed";
+}
+
+// Splits ';'- or newline-separated entries, dropping comments and blank ones.
+static std::vector<std::string> split_entries(const std::string& text)
+{
+    std::string flat = text;
+    for (char& c : flat)
+        if (c == ';')
+            c = '\n';
+
+    std::vector<std::string> entries;
+    std::istringstream in(flat);
+    std::string line;
+    while (std::getline(in, line))
+    {
+        line = line.substr(0, line.find('#'));
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos)
+            continue;
+        entries.push_back(line.substr(first, line.find_last_not_of(" \t\r") + 1 - first));
+    }
+    return entries;
+}
+
+static bool read_file(const std::string& path, const char* what, std::string& text, std::string& err)
+{
+    std::ifstream f(path);
+    if (!f)
+    {
+        err = std::string("cannot open ") + what + " '" + path + "'";
+        return false;
+    }
+    std::stringstream ss;
+    ss << f.rdbuf();
+    text = ss.str();
+    return true;
+}
+
+static bool parse_phase(const std::string& text, ScenarioPhase& ph, std::string& err)
+{
+    std::istringstream ss(text);
+    std::string duration, kv;
+    if (!(ss >> ph.name >> duration))
+    {
+        err = "phase '" + text + "' needs a name and a duration";
+        return false;
+    }
+
+    if (duration == "drained")
+        ph.until_drained = true;
+    else if (duration == "steady")
+        ph.until_steady = true;
+    else
+    {
+        char* unit = nullptr;
+        const double v = std::strtod(duration.c_str(), &unit);
+        const std::string u(unit);
+        if (u.empty() || u == "us")
+            ph.duration_us = v;
+        else if (u == "ns")
+            ph.duration_us = v / 1e3;
+        else if (u == "ms")
+            ph.duration_us = v * 1e3;
+        else
+            ph.duration_us = -1.0;
+        if (ph.duration_us <= 0.0)
+        {
+            err = "phase '" + ph.name + "': bad duration '" + duration + "'";
+            return false;
+        }
+    }
+
+    while (ss >> kv)
+    {
+        const size_t eq = kv.find('=');
+        const std::string key = kv.substr(0, eq);
+        if (eq == std::string::npos || !known_key(key))
+        {
+            err = "phase '" + ph.name + "': unknown setting '" + kv + "'";
+            return false;
+        }
+        ph.settings.emplace_back(key, kv.substr(eq + 1));
+    }
+    return true;
+}
+
+bool parse_scenario(const std::string& text, std::vector<ScenarioPhase>& phases, std::string& err)
+{
+    for (const std::string& line : split_entries(text))
+    {
+        ScenarioPhase ph;
+        if (!parse_phase(line, ph, err))
+            return false;
+        phases.push_back(ph);
+    }
+    if (phases.empty())
+    {
+        err = "scenario has no phases";
+        return false;
+    }
+    return true;
+}
+
+bool load_scenario(const std::string& path, std::vector<ScenarioPhase>& phases, std::string& err)
+{
+    std::string text;
+    return read_file(path, "scenario", text, err) && parse_scenario(text, phases, err);
+}
+
+bool parse_reruns(const std::string& text, std::vector<ScenarioRerun>& runs, std::string& err)
+{
+    for (const std::string& line : split_entries(text))
+    {
+        ScenarioRerun run;
+        run.label = line;
+        std::istringstream ss(line);
+        std::string kv;
+        while (ss >> kv)
+        {
+            const size_t eq = kv.find('=');
+            const std::string key = kv.substr(0, eq);
+            if (eq == std::string::npos || !known_key(key, true))
+            {
+                err = "re-run '" + line + "': unknown setting '" + kv + "'";
+                return false;
+            }
+            run.settings.emplace_back(key, kv.substr(eq + 1));
+        }
+        runs.push_back(run);
+    }
+    if (runs.empty())
+    {
+        err = "re-run list is empty";
+        return false;
+    }
+    return true;
+}
+
+bool load_reruns(const std::string& path, std::vector<ScenarioRerun>& runs, std::string& err)
+{
+    std::string text;
+    return read_file(path, "re-run list", text, err) && parse_reruns(text, runs, err);
+}
@@ -0,0 +1,59 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// Scenario: the timed phases sc_main runs after reset.  A phase is written
+//
+//     <name> <duration> [key=value ...]
+//
+// one per line in a file ('#' starts a comment) or separated by ';' on the
+// command line.  duration is a number with an optional ns/us/ms suffix
+// (default us), "drained" to run until the data paths have been quiet for
+// SCENARIO_QUIET_US, or "steady" to run until throughput and latency of both
+// paths have converged (see steady.h).  Settings apply at the start of the
+// phase and persist:
+//
+//     load=<pct>          open-loop offered load (--load)
+//     traffic=on|off      create new packets (arrivals, or saturated sends)
+//     pop=on|off          iEP consumers pop at all
+//     drain=<model>       consumer model (--drain)
+//     drain-rate=<pct>    consumer rate (--drain-rate)
+//     stall=<pct>         data NoC stall percentage
+//     credit-stall=<pct>  credit NoC stall percentage
+//     window=<cycles>     fixed CreditTx sense window (--credit-window)
+//
+// Re-runs run the whole scenario again in the same process, once per entry.
+// An entry is a list of the settings above plus seed=<n> (--seed), entries
+// separated by ';' or one per line in a file.  Every run starts from the
+// command-line configuration with that entry's settings applied; runs after
+// the first begin with a soft reset.
+// -----------------------------------------------------------------------------
+
+struct ScenarioPhase {
+    std::string name;
+    double duration_us = 0.0;     // ignored when until_drained/until_steady
+    bool until_drained = false;
+    bool until_steady = false;
+    std::vector<std::pair<std::string, std::string>> settings;
+};
+
+// Parses phases from 'text'; on a malformed phase returns false and sets err.
+bool parse_scenario(const std::string& text, std::vector<ScenarioPhase>& phases, std::string& err);
+
+// Reads a scenario file; false (with err) if it cannot be read or parsed.
+bool load_scenario(const std::string& path, std::vector<ScenarioPhase>& phases, std::string& err);
+
+struct ScenarioRerun {
+    std::string label;            // the entry as written
+    std::vector<std::pair<std::string, std::string>> settings;
+};
+
+// Parses re-run entries from 'text' or a file, like the phase functions.
+bool parse_reruns(const std::string& text, std::vector<ScenarioRerun>& runs, std::string& err);
+bool load_reruns(const std::string& path, std::vector<ScenarioRerun>& runs, std::string& err);
+
+#endif // SCENARIO_H
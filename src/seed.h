@@ -0,0 +1,29 @@
+#ifndef SEED_H
+#define SEED_H
+
+#include <cstdint>
+#include <string>
+
+// -----------------------------------------------------------------------------
+// stream_seed: seed of one module's RNG stream, derived from the run seed
+// (--seed) and a stream name (the module name).  The name is hashed (FNV-1a)
+// and mixed with the run seed through splitmix64, so streams of one run are
+// unrelated to each other and to the streams of any other run seed.  Adding
+// offsets to the run seed instead would make run N's second stream run
+// N+1's first one.
+// -----------------------------------------------------------------------------
+
+inline unsigned stream_seed(unsigned run_seed, const std::string& stream)
+{
+    uint64_t h = 1469598103934665603ull;
+    for (char c : stream)
+        h = (h ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+
+    uint64_t z = h + (static_cast<uint64_t>(run_seed) + 1) * 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    z ^= z >> 31;
+    return static_cast<unsigned>(z ^ (z >> 32));
+}
+
+#endif // SEED_H
@@ -0,0 +1,106 @@
+#include "steady.h"
+
+#include <cmath>
+
+// Two-sided 95% Student t quantile for 'dof' degrees of freedom.
+static double t95(unsigned dof)
+{
+    static const double table[] = {
+        0.0,   12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262,
+        2.228, 2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093,
+        2.086, 2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045,
+        2.042,
+    };
+    if (dof == 0)
+        return INFINITY;
+    return dof < sizeof(table) / sizeof(table[0]) ? table[dof] : 1.96 + 2.4 / dof;
+}
+
+BatchMeans::BatchMeans(unsigned n, unsigned warm, unsigned min_b)
+    : metrics(n), warmup(warm), min_batches(min_b < 2 ? 2 : min_b)
+{
+}
+
+void BatchMeans::add(const std::vector<double>& batch)
+{
+    if (seen++ < warmup)
+        return;
+    // the caller only adds more while not converged
+    if (kept.size() >= 2 * min_batches)
+        merge_pairs();
+    if (pending_n == 0)
+        pending.assign(metrics, 0.0);
+    for (unsigned m = 0; m < metrics; ++m)
+        pending[m] += batch[m];
+    if (++pending_n < group)
+        return;
+    for (double& v : pending)
+        v /= group;
+    kept.push_back(pending);
+    pending_n = 0;
+}
+
+// Halve the kept batches by averaging neighbours; later batches are twice
+// as long.  Only called with an even number of kept batches and nothing
+// pending.
+void BatchMeans::merge_pairs()
+{
+    std::vector<std::vector<double>> merged;
+    for (size_t i = 0; i + 1 < kept.size(); i += 2) {
+        std::vector<double> row(metrics);
+        for (unsigned m = 0; m < metrics; ++m)
+            row[m] = (kept[i][m] + kept[i + 1][m]) / 2;
+        merged.push_back(row);
+    }
+    kept.swap(merged);
+    group *= 2;
+}
+
+double BatchMeans::mean(unsigned m) const
+{
+    if (kept.empty())
+        return 0.0;
+    double sum = 0.0;
+    for (const auto& b : kept)
+        sum += b[m];
+    return sum / kept.size();
+}
+
+double BatchMeans::half_width(unsigned m) const
+{
+    const size_t n = kept.size();
+    if (n < 2)
+        return INFINITY;
+    const double mu = mean(m);
+    double ss = 0.0;
+    for (const auto& b : kept)
+        ss += (b[m] - mu) * (b[m] - mu);
+    return t95(static_cast<unsigned>(n - 1)) * std::sqrt(ss / (n - 1) / n);
+}
+
+bool BatchMeans::metric_converged(unsigned m, double tol) const
+{
+    const double mu = mean(m);
+    if (mu == 0.0)
+        return true;
+    if (half_width(m) > tol * std::fabs(mu))
+        return false;
+
+    const size_t half = kept.size() / 2;
+    double first = 0.0, second = 0.0;
+    for (size_t i = 0; i < half; ++i)
+        first += kept[i][m];
+    for (size_t i = kept.size() - half; i < kept.size(); ++i)
+        second += kept[i][m];
+    return std::fabs(second - first) / half <= tol * std::fabs(mu);
+}
+
+bool BatchMeans::converged(double tol) const
+{
+    if (kept.size() < min_batches)
+        return false;
+    for (unsigned m = 0; m < metrics; ++m)
+        if (!metric_converged(m, tol))
+            return false;
+    return true;
+}
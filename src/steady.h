@@ -0,0 +1,45 @@
+#ifndef STEADY_H
+#define STEADY_H
+
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// BatchMeans: online steady-state test.  Each add() contributes one batch
+// mean per metric.  After dropping the first 'warmup' batches, a metric has
+// converged once at least 'min_batches' are kept, the 95% confidence
+// half-width of their mean is within 'tol' (relative) of the mean, and the
+// two halves of the kept batches agree within 'tol' (no trend, e.g. a queue
+// that keeps growing under overload).  Metrics with a zero mean (idle path)
+// do not hold up convergence.  Batches that are short next to the model's
+// burst period (e.g. a credit RTT) vary too much to ever agree, so whenever
+// 2 * 'min_batches' are kept without converging, adjacent pairs are merged
+// and later batches cover twice as many add() calls.
+// -----------------------------------------------------------------------------
+
+class BatchMeans {
+public:
+    BatchMeans(unsigned metrics, unsigned warmup, unsigned min_batches);
+
+    void add(const std::vector<double>& batch);
+    bool converged(double tol) const;
+
+    unsigned batches() const { return static_cast<unsigned>(kept.size()); }
+    unsigned batch_len() const { return group; }   // add() calls per kept batch
+    double   mean(unsigned m) const;
+    double   half_width(unsigned m) const;   // 95% confidence half-width
+
+private:
+    bool metric_converged(unsigned m, double tol) const;
+    void merge_pairs();
+
+    const unsigned metrics;
+    const unsigned warmup;
+    const unsigned min_batches;
+    unsigned seen = 0;
+    unsigned group = 1;                      // add() calls per kept batch
+    std::vector<double> pending;             // sum of the batch being built
+    unsigned pending_n = 0;
+    std::vector<std::vector<double>> kept;   // one row per kept batch
+};
+
+#endif // STEADY_H
@@ -0,0 +1,269 @@
+#include "traffic.h"
+#include "checkpoint.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+void TrafficModel::save(std::ostream& os) const
+{
+    ckpt_save(os, rng);
+}
+
+void TrafficModel::load(std::istream& is)
+{
+    ckpt_load(is, rng);
+}
+
+ConstantTraffic::ConstantTraffic(const std::vector<double>& rates, unsigned seed)
+    : TrafficModel(rates, seed), acc(rates.size(), 0.0)
+{
+}
+
+unsigned ConstantTraffic::arrivals(unsigned t)
+{
+    acc[t] += rate[t];
+    unsigned n = static_cast<unsigned>(acc[t]);
+    acc[t] -= n;
+    return n;
+}
+
+void ConstantTraffic::save(std::ostream& os) const
+{
+    TrafficModel::save(os);
+    ckpt_save(os, acc);
+}
+
+void ConstantTraffic::load(std::istream& is)
+{
+    TrafficModel::load(is);
+    ckpt_load(is, acc);
+}
+
+PoissonTraffic::PoissonTraffic(const std::vector<double>& rates, unsigned seed)
+    : TrafficModel(rates, seed)
+{
+    for (double r : rates)
+        dist.emplace_back(r > 0.0 ? r : 1.0);
+}
+
+unsigned PoissonTraffic::arrivals(unsigned t)
+{
+    return rate[t] > 0.0 ? dist[t](rng) : 0;
+}
+
+void PoissonTraffic::save(std::ostream& os) const
+{
+    TrafficModel::save(os);
+    ckpt_save(os, dist);
+}
+
+void PoissonTraffic::load(std::istream& is)
+{
+    TrafficModel::load(is);
+    ckpt_load(is, dist);
+}
+
+OnOffTraffic::OnOffTraffic(const std::vector<double>& rates, unsigned seed, unsigned burst)
+    : TrafficModel(rates, seed), on(rates.size(), false), p_off(rates.size()), p_on(rates.size())
+{
+    const double b = burst ? burst : 1;
+    for (size_t t = 0; t < rates.size(); ++t)
+    {
+        // duty cycle f = rate: mean on = b cycles, mean off = b * (1 - f) / f
+        const double f = rates[t];
+        p_off[t] = f >= 1.0 ? 0.0 : 1.0 / b;
+        p_on[t]  = f <= 0.0 ? 0.0 : f >= 1.0 ? 1.0 : f / (b * (1.0 - f));
+        if (p_on[t] > 1.0)
+            p_on[t] = 1.0;
+    }
+}
+
+unsigned OnOffTraffic::arrivals(unsigned t)
+{
+    if (on[t])
+        on[t] = u(rng) >= p_off[t];
+    else
+        on[t] = u(rng) < p_on[t];
+    return on[t] ? 1 : 0;
+}
+
+void OnOffTraffic::save(std::ostream& os) const
+{
+    TrafficModel::save(os);
+    ckpt_save(os, on);
+}
+
+void OnOffTraffic::load(std::istream& is)
+{
+    TrafficModel::load(is);
+    ckpt_load(is, on);
+}
+
+TraceReader::TraceReader(const std::string& file, double clk_ns)
+    : in(file), path(file), cycle_ns(clk_ns)
+{
+    have_next = ok() && read_next();
+}
+
+bool TraceReader::read_next()
+{
+    std::string line;
+    while (std::getline(in, line))
+    {
+        lines++;
+        line = line.substr(0, line.find('#'));
+        for (char& c : line)
+            if (c == ',')
+                c = ' ';
+        std::istringstream ss(line);
+        std::string time;
+        long thread = 0, value = 0;
+        if (!(ss >> time))
+            continue;   // blank or comment
+        if (!(ss >> thread >> value) || thread < 1 || thread > 3 || value < 0)
+        {
+            malformed++;
+            continue;
+        }
+
+        char* unit = nullptr;
+        double v = std::strtod(time.c_str(), &unit);
+        const std::string u(unit);
+        double cycles = v;
+        if (u == "ns")
+            cycles = v / cycle_ns;
+        else if (u == "us")
+            cycles = v * 1e3 / cycle_ns;
+        else if (u == "ms")
+            cycles = v * 1e6 / cycle_ns;
+        else if (!u.empty() || v < 0)
+        {
+            malformed++;
+            continue;
+        }
+
+        next.cycle  = static_cast<uint64_t>(std::llround(cycles));
+        next.thread = static_cast<unsigned>(thread - 1);
+        next.value  = static_cast<unsigned long>(value);
+        if (records && next.cycle < last_cycle)
+            out_of_order++;   // replayed as soon as it is read
+        last_cycle = std::max(last_cycle, next.cycle);
+        records++;
+        return true;
+    }
+    eof = true;
+    return false;
+}
+
+void TraceReader::take(uint64_t cycle, std::vector<unsigned>& due, unsigned unit)
+{
+    while (have_next && next.cycle <= cycle)
+    {
+        due[next.thread] += static_cast<unsigned>((next.value + unit - 1) / unit);
+        have_next = read_next();
+    }
+}
+
+void TraceReader::report(std::ostream& os, uint64_t cycle) const
+{
+    os << "Trace " << path << " : " << records << " records";
+    if (malformed)
+        os << ", " << malformed << " malformed (skipped)";
+    if (out_of_order)
+        os << ", " << out_of_order << " out of order";
+    os << "\n";
+    if (finished())
+        os << "Trace ended at recorded cycle " << last_cycle << ", replayed through cycle " << cycle << "\n";
+    else
+        os << "Trace not finished: replayed through cycle " << cycle << " of at least " << last_cycle << "\n";
+}
+
+void TraceReader::save(std::ostream& os) const
+{
+    ckpt_save(os, lines, have_next, next.cycle, next.thread, next.value,
+              records, malformed, out_of_order, last_cycle, eof);
+}
+
+void TraceReader::load(std::istream& is)
+{
+    ckpt_load(is, lines, have_next, next.cycle, next.thread, next.value,
+              records, malformed, out_of_order, last_cycle, eof);
+    in.clear();
+    in.seekg(0);
+    std::string line;
+    for (uint64_t n = 0; n < lines && std::getline(in, line); ++n)
+    {
+    }
+}
+
+TraceTraffic::TraceTraffic(const std::string& file, double clk_ns)
+    : TrafficModel(std::vector<double>(3, 0.0), 0), reader(file, clk_ns), cycle_ns(clk_ns),
+      due(3, 0), total(3, 0)
+{
+}
+
+void TraceTraffic::tick()
+{
+    std::fill(due.begin(), due.end(), 0u);
+    for (auto& l : late)
+        l.clear();
+    while (const TraceReader::Record* r = reader.due_by(cycle))
+    {
+        // a full queue holds this record and, to keep the order, all after it
+        if (!room.empty() && due[r->thread] >= room[r->thread])
+        {
+            held_cycles++;
+            break;
+        }
+        const unsigned n = static_cast<unsigned>((r->value + 7) / 8);   // bytes -> 64-bit packets
+        due[r->thread] += n;
+        late[r->thread].insert(late[r->thread].end(), n, cycle - r->cycle);
+        reader.pop();
+    }
+    for (size_t t = 0; t < due.size(); ++t)
+        total[t] += due[t];
+    cycle++;
+}
+
+unsigned TraceTraffic::arrivals(unsigned t)
+{
+    return due[t];
+}
+
+double TraceTraffic::rate_of(unsigned t) const
+{
+    return cycle ? static_cast<double>(total[t]) / cycle : 0.0;
+}
+
+void TraceTraffic::report(std::ostream& os) const
+{
+    reader.report(os, cycle);
+    if (held_cycles)
+        os << "Replay held back " << held_cycles << " cycles by a full source queue\n";
+}
+
+void TraceTraffic::save(std::ostream& os) const
+{
+    ckpt_save(os, cycle, due, late, total, held_cycles);
+    reader.save(os);
+}
+
+void TraceTraffic::load(std::istream& is)
+{
+    ckpt_load(is, cycle, due, late, total, held_cycles);
+    reader.load(is);
+}
+
+TrafficModel* make_traffic(const std::string& kind, const std::vector<double>& rates,
+                           unsigned seed, unsigned burst)
+{
+    if (kind == "const")
+        return new ConstantTraffic(rates, seed);
+    if (kind == "poisson")
+        return new PoissonTraffic(rates, seed);
+    if (kind == "onoff")
+        return new OnOffTraffic(rates, seed, burst);
+    return nullptr;
+}
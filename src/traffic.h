@@ -0,0 +1,175 @@
+#ifndef TRAFFIC_H
+#define TRAFFIC_H
+
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// TrafficModel: open-loop packet arrivals for iRC.  Each cycle iRC calls
+// tick() once and then arrivals(t) for every thread; arrivals(t) returns how
+// many packets thread t generates in that cycle, independent of credits, and
+// iRC queues them in per-thread source queues.  rates are mean packets per
+// cycle, one per thread.
+// -----------------------------------------------------------------------------
+
+class TrafficModel {
+public:
+    TrafficModel(const std::vector<double>& rates, unsigned seed) : rate(rates), rng(seed) {}
+    virtual ~TrafficModel() {}
+
+    virtual void tick() {}
+    virtual unsigned arrivals(unsigned t) = 0;
+    virtual const char* kind() const = 0;
+
+    // Full source queues.  Before each tick() iRC passes the free entries of
+    // every thread's source queue.  A model that must not lose arrivals (a
+    // trace) holds them back while the queue is full and releases them late;
+    // late_ns(t, k) is how long the k-th arrival of thread t this cycle was
+    // held.  For the other models iRC drops what does not fit.
+    virtual bool holds_back() const { return false; }
+    virtual void set_room(const std::vector<unsigned>&) {}
+    virtual double late_ns(unsigned, unsigned) const { return 0.0; }
+    virtual double rate_of(unsigned t) const { return rate[t]; }
+    virtual void report(std::ostream&) const {}
+
+    // Checkpoint of the running state (see checkpoint.h).  Rates are
+    // configuration: a model restored with other rates keeps its RNG and
+    // accumulators.
+    virtual void save(std::ostream& os) const;
+    virtual void load(std::istream& is);
+
+    unsigned threads() const { return static_cast<unsigned>(rate.size()); }
+
+protected:
+    std::vector<double> rate;
+    std::mt19937 rng;
+};
+
+// Deterministic, evenly spaced arrivals (fractional accumulator per thread).
+class ConstantTraffic : public TrafficModel {
+public:
+    ConstantTraffic(const std::vector<double>& rates, unsigned seed);
+    unsigned arrivals(unsigned t) override;
+    const char* kind() const override { return "const"; }
+    void save(std::ostream& os) const override;
+    void load(std::istream& is) override;
+
+private:
+    std::vector<double> acc;
+};
+
+// Poisson arrivals: a Poisson-distributed count per cycle with mean rate[t].
+class PoissonTraffic : public TrafficModel {
+public:
+    PoissonTraffic(const std::vector<double>& rates, unsigned seed);
+    unsigned arrivals(unsigned t) override;
+    const char* kind() const override { return "poisson"; }
+    void save(std::ostream& os) const override;
+    void load(std::istream& is) override;
+
+private:
+    std::vector<std::poisson_distribution<unsigned>> dist;
+};
+
+// On/off bursts: one packet per cycle while on, nothing while off.  On and
+// off periods are geometric; the mean burst is 'burst' cycles and the mean
+// gap is chosen so the long-run rate is rate[t].
+class OnOffTraffic : public TrafficModel {
+public:
+    OnOffTraffic(const std::vector<double>& rates, unsigned seed, unsigned burst);
+    unsigned arrivals(unsigned t) override;
+    const char* kind() const override { return "onoff"; }
+    void save(std::ostream& os) const override;
+    void load(std::istream& is) override;
+
+private:
+    std::vector<bool>   on;
+    std::vector<double> p_off;   // per-cycle probability to end a burst
+    std::vector<double> p_on;    // per-cycle probability to start one
+    std::uniform_real_distribution<double> u{0.0, 1.0};
+};
+
+// Streaming reader for "<time> <thread_id> <value>" record files, shared by
+// trace-driven traffic and drain models.  Commas also separate fields and '#'
+// starts a comment.  time is a cycle number (0 = first cycle after reset) or a
+// timestamp with an ns/us/ms suffix; thread_id is 1-3.  Records must be in
+// time order.  The file is read one record ahead, so memory does not grow
+// with the trace length.
+class TraceReader {
+public:
+    TraceReader(const std::string& path, double cycle_ns);
+    bool ok() const { return in.is_open(); }
+
+    struct Record { uint64_t cycle; unsigned thread; unsigned long value; };
+
+    // Adds the value of every record due by 'cycle' to due[thread]; values
+    // are divided by 'unit', rounding up.
+    void take(uint64_t cycle, std::vector<unsigned>& due, unsigned unit = 1);
+    // The next record if it is due by 'cycle' (else nullptr); pop() moves on.
+    const Record* due_by(uint64_t cycle) const { return have_next && next.cycle <= cycle ? &next : nullptr; }
+    void pop() { have_next = read_next(); }
+    bool finished() const { return eof && !have_next; }
+    void report(std::ostream& os, uint64_t cycle) const;
+
+    // Checkpoint of the read position; loading rereads the file up to it.
+    void save(std::ostream& os) const;
+    void load(std::istream& is);
+
+private:
+    bool read_next();   // next record into 'next'; false at end of file
+
+    std::ifstream in;
+    std::string   path;
+    double        cycle_ns;
+    bool          have_next = false;
+    Record        next{};
+    uint64_t records = 0;
+    uint64_t malformed = 0;
+    uint64_t out_of_order = 0;    // records stamped earlier than their predecessor
+    uint64_t last_cycle = 0;      // recorded time of the last record read
+    bool     eof = false;
+    uint64_t lines = 0;           // lines consumed, for checkpoints
+};
+
+// Replay of a captured trace: the value is a size in bytes and becomes
+// ceil(size / 8) packets, one per 64-bit beat, released at the recorded time.
+// No record is lost: while the source queue of the next record's thread is
+// full, reading stops and the records after it are released late.
+class TraceTraffic : public TrafficModel {
+public:
+    TraceTraffic(const std::string& path, double cycle_ns);
+    bool ok() const { return reader.ok(); }
+
+    void tick() override;
+    unsigned arrivals(unsigned t) override;
+    const char* kind() const override { return "trace"; }
+    bool holds_back() const override { return true; }
+    void set_room(const std::vector<unsigned>& r) override { room = r; }
+    double late_ns(unsigned t, unsigned k) const override { return late[t][k] * cycle_ns; }
+    double rate_of(unsigned t) const override;
+    void report(std::ostream& os) const override;
+    void save(std::ostream& os) const override;
+    void load(std::istream& is) override;
+
+private:
+    TraceReader reader;
+    double   cycle_ns;
+    uint64_t cycle = 0;
+    std::vector<unsigned> due;    // packets released this cycle, per thread
+    std::vector<uint64_t> late[3];  // cycles each of them was held back
+    std::vector<uint64_t> total;  // packets released so far, per thread
+    std::vector<unsigned> room;   // free source-queue entries (empty: unlimited)
+    uint64_t held_cycles = 0;     // cycles a full source queue stopped the replay
+};
+
+// Factory by model name: "const", "poisson" or "onoff".  Returns nullptr for
+// an unknown name ("sat", the credit-driven default, has no model).
+TrafficModel* make_traffic(const std::string& kind, const std::vector<double>& rates,
+                           unsigned seed, unsigned burst = 16);
+
+#endif // TRAFFIC_H